@@ -28,15 +28,213 @@ For more information, please refer to <http://unlicense.org/>
 #ifndef JSONPARSER_H_
 #define JSONPARSER_H_
 
+#if defined(__AVX2__)
+#define JSONPARSER_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#define JSONPARSER_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* The whitespace, comment and string scanners read whole aligned 16-byte
+   blocks, and numbers are read eight digits at a time. Both may look
+   past the terminating NUL, but never into another page. */
+#if defined(__SANITIZE_ADDRESS__) && defined(_MSC_VER)
+#define JSONPARSER_NO_SANITIZE __declspec(no_sanitize_address)
+#elif defined(__SANITIZE_ADDRESS__)
+#define JSONPARSER_NO_SANITIZE __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define JSONPARSER_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef JSONPARSER_NO_SANITIZE
+#define JSONPARSER_NO_SANITIZE
+#endif
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) \
+  || defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+#define JSONPARSER_LITTLE_ENDIAN
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <new>
+#include <set>
+#include <stdint.h>
+#include <sstream>
+#include <string>
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define JSONPARSER_CXX17
+#include <string_view>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#endif
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#define JSONPARSER_CXX20
+#endif
+#include <vector>
+
+#if __cplusplus >= 201103L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L)
+#define JSONPARSER_CXX11
+#define JSONPARSER_CONSTEXPR constexpr
+#define JSONPARSER_THREAD_LOCAL thread_local
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#else
+#define JSONPARSER_CONSTEXPR
+#define JSONPARSER_THREAD_LOCAL __thread
+#include <pthread.h>
+#endif
+
+/* Numbers that cannot be converted exactly from their digits need a
+   strtod() that ignores the current locale */
+#if defined(__cpp_lib_to_chars)
+#define JSONPARSER_FROM_CHARS
+#elif defined(_MSC_VER) || defined(__unix__) || defined(__APPLE__)
+#define JSONPARSER_STRTOD_L
+#include <locale.h>
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JSONPARSER_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace Json
 {
 
   typedef enum
   {
-    T_NUMBER, T_STRING, T_BOOLEAN, T_ARRAY, T_OBJECT
+    T_NUMBER, T_STRING, T_BOOLEAN, T_ARRAY, T_OBJECT,
+    T_NULL   // only used by Document nodes; a null Value is NULL
   } 
   Type;
 
+  /* How a number literal was stored: integers that fit in 64 bits keep
+     their exact value next to the nearest double */
+  typedef enum
+  {
+    N_DOUBLE, N_INT64, N_UINT64
+  }
+  NumberKind;
+
+  /* Options for Document::parse, combined with | */
+  typedef enum
+  {
+    P_DEFAULT = 0,
+    P_ZERO_COPY = 1,   // strings and keys refer to the input instead of being copied
+    P_INSITU = 2,      // strings are decoded in the input buffer; set by parseInsitu(), or passed to parseFile()
+    P_SORTED_KEYS = 4, // order object members by key, keeping the last of duplicates
+    P_PARALLEL = 8,    // parse a large top-level array on several threads (C++11 only)
+    P_LAZY = 16        // parse each container only when it is first read
+  }
+  ParseFlags;
+
+  /* Parsers fail on containers nested deeper than this, unless set
+     otherwise, rather than let a hostile input exhaust their stack */
+  static const size_t DEFAULT_MAX_DEPTH = 1024;
+
+  /* Why a parse failed */
+  typedef enum
+  {
+    E_NONE,
+    E_UNEXPECTED_END,       // the input ends in the middle of a value
+    E_UNEXPECTED_CHARACTER, // a character that has no place where it is
+    E_INVALID_LITERAL,      // neither a string, a number, true, false nor null
+    E_INVALID_ESCAPE,       // a malformed escape sequence in a string
+    E_INVALID_UTF8,         // a string holding bytes that are not UTF-8
+    E_UNTERMINATED_STRING,  // a string without its closing quote
+    E_EXPECTED_KEY,         // an object member not starting with a quoted key
+    E_EXPECTED_COLON,       // a key not followed by ':'
+    E_EXPECTED_SEPARATOR,   // a value not followed by ',' or the closing bracket
+    E_UNBALANCED,           // brackets that do not match
+    E_WRONG_TYPE,           // a value of another type than asked for
+    E_TOO_DEEP,             // containers nested more than the maximum depth
+    E_HANDLER,              // a handler returned false
+    E_IO,                   // a file that could not be opened or read
+    E_TOO_LARGE             // a string or container longer than a Node can hold
+  }
+  ErrorCode;
+
+  /* Where and why a parse failed. Nothing is printed when parsing
+     fails; the parser records the error and returns, and the line and
+     column are only worked out from the input when they are asked for,
+     so rejecting input costs no more than accepting it. */
+  struct Error
+  {
+    ErrorCode code;
+    size_t offset;      // in bytes from the start of the input
+    const char* input;  // the input, or NULL if it was not kept
+
+    Error() : code(E_NONE), offset(0), input(NULL) {}
+    Error(ErrorCode c, size_t at, const char* in = NULL) : code(c), offset(at), input(in) {}
+
+    /* Line and column of the error, both counted from 1 and columns in
+       bytes. The input must still be alive; without it both are 0. */
+    size_t line() const
+    {
+      return input ? (size_t) std::count(input, input + offset, '\n') + 1 : 0;
+    }
+
+    size_t column() const
+    {
+      if (!input)
+        return 0;
+      size_t start = offset;
+      while (start > 0 && input[start - 1] != '\n')
+        start--;
+      return offset - start + 1;
+    }
+
+    const char* message() const
+    {
+      switch (code)
+      {
+      case E_NONE: return "no error";
+      case E_UNEXPECTED_END: return "unexpected end of input";
+      case E_UNEXPECTED_CHARACTER: return "unexpected character";
+      case E_INVALID_LITERAL: return "invalid literal";
+      case E_INVALID_ESCAPE: return "invalid escape sequence";
+      case E_INVALID_UTF8: return "invalid UTF-8";
+      case E_UNTERMINATED_STRING: return "string without closing quote";
+      case E_EXPECTED_KEY: return "expected '\"' to start an object key";
+      case E_EXPECTED_COLON: return "expected ':' after an object key";
+      case E_EXPECTED_SEPARATOR: return "expected ',' or closing bracket";
+      case E_UNBALANCED: return "unbalanced brackets";
+      case E_TOO_DEEP: return "containers nested too deep";
+      case E_WRONG_TYPE: return "value of the wrong type";
+      case E_HANDLER: return "stopped by handler";
+      case E_IO: return "unable to read file";
+      case E_TOO_LARGE: return "string or container too large";
+      }
+      return "unknown error";
+    }
+  };
+
   struct Value 
   {
     Value(){}
@@ -48,12 +246,45 @@ namespace Json
   struct Number : public Value
   {
     double v;
-    Number() : v(0) {}
-    Number(double in) : v(in) {}
-    Number(const Number& in) : v(in.v) {}
+    NumberKind kind;
+    union
+    {
+      int64_t i;    // when kind is N_INT64
+      uint64_t u;   // when kind is N_UINT64
+    };
+    Number() : v(0), kind(N_DOUBLE) { i = 0; }
+    Number(double in) : v(in), kind(N_DOUBLE) { i = 0; }
+    Number(const Number& in) : v(in.v), kind(in.kind) { i = in.i; }
     virtual ~Number(){}
 
     double value() const { return v; }
+    NumberKind getKind() const { return kind; }
+    bool isInteger() const { return kind != N_DOUBLE; }
+
+    /* The exact value of an integer literal. Other numbers are truncated
+       toward zero and clamped to the range of the result; NaN gives 0. */
+    int64_t asInt64() const
+    {
+      if (kind == N_INT64)
+        return i;
+      if (kind == N_UINT64)
+        return u > (uint64_t) std::numeric_limits<int64_t>::max()
+          ? std::numeric_limits<int64_t>::max() : (int64_t) u;
+      if (!(v > -9223372036854775808.0))
+        return v != v ? 0 : std::numeric_limits<int64_t>::min();
+      return v < 9223372036854775808.0 ? (int64_t) v : std::numeric_limits<int64_t>::max();
+    }
+
+    uint64_t asUInt64() const
+    {
+      if (kind == N_UINT64)
+        return u;
+      if (kind == N_INT64)
+        return i < 0 ? 0 : (uint64_t) i;
+      if (!(v > 0))
+        return 0;
+      return v < 18446744073709551616.0 ? (uint64_t) v : std::numeric_limits<uint64_t>::max();
+    }
 
     static const Type TYPE = T_NUMBER;
     virtual Type getType() const { return TYPE; }
@@ -176,376 +407,5404 @@ namespace Json
   };
 
 
-
   namespace impl {
 
-    Value* parseGeneric(char*& s);
+    /* The last failure on this thread, kept like errno: at is where in
+       input it happened. Once the input is gone, offset holds the
+       position instead. */
+    struct Failure
+    {
+      ErrorCode code;
+      const char* at;
+      const char* input;
+      size_t offset;
+    };
 
-    inline bool chompComment(char*& s)
+    inline Failure& failure()
     {
-      if (*(s) == '/' && *(s + 1) == '/')
-      {
-        s += 2;
-        while (*s != '\n')
-          ++s;
-        return true;
-      }
-      return false;
+      static JSONPARSER_THREAD_LOCAL Failure last;
+      return last;
     }
 
-    inline bool chompSpace(char*& s)
+    /* Record a failure and return false. A syntax error found at the
+       terminating NUL is reported as the end of the input. */
+    inline bool fail(ErrorCode code, const char* at)
     {
-      if (isspace(*s))
-      {
-        while (isspace(*s))
-          ++s;
-        return true;
-      }
+      Failure& f = failure();
+      f.code = at && !*at && code >= E_UNEXPECTED_CHARACTER && code <= E_WRONG_TYPE
+        ? E_UNEXPECTED_END : code;
+      f.at = at;
       return false;
     }
 
-    inline void chomp(char*& s)
+    /* Start a parse of input, forgetting any earlier failure */
+    inline void begin(const char* input)
     {
-      while (chompSpace(s) || chompComment(s))
-        ;
+      Failure& f = failure();
+      f.code = E_NONE;
+      f.at = NULL;
+      f.input = input;
+      f.offset = 0;
     }
 
-    inline std::string parseCharString(char*& s)
+    /* Keep the offset of the last failure but forget its input, which
+       is about to be released */
+    inline void detach()
     {
-      char *prev;
-
-      std::string result; 
-      result.reserve(16);
-
-      chomp(s);
+      Failure& f = failure();
+      if (f.at && f.input && f.at >= f.input)
+        f.offset = f.at - f.input;
+      f.input = NULL;
+    }
 
-      if(*s != '"') {
-        fprintf(stderr, "parseFieldName error, expected '\"'. Got: %s\n", s);
-        return result;
-      }
+    /* The last failure, as an Error located in the input it was in */
+    inline Error lastError()
+    {
+      const Failure& f = failure();
+      if (f.at && f.input && f.at >= f.input)
+        return Error(f.code, f.at - f.input, f.input);
+      return Error(f.code, f.offset);
+    }
 
-      prev = s;
-      s++;
+    /* Bump allocator backing a Document. Memory is handed out from a
+       chain of large blocks and only released all at once, so nodes
+       placed in an Arena are never destroyed individually. */
+    class Arena
+    {
+    public:
+      Arena(size_t initial = 4096)
+        : head(NULL), spare(NULL), cursor(NULL), limit(NULL), next(initial) {}
+      ~Arena() { clear(); }
 
-      do {
-        if(*prev != '\\' && *s == '"') {
-          s++;
-          break;
+      void* allocate(size_t size, size_t align = sizeof(void*))
+      {
+        size_t pad = (align - ((size_t) cursor & (align - 1))) & (align - 1);
+        if (cursor == NULL || size + pad > (size_t) (limit - cursor))
+        {
+          grow(size + align);
+          pad = (align - ((size_t) cursor & (align - 1))) & (align - 1);
         }
+        char* p = cursor + pad;
+        cursor = p + size;
+        return p;
+      }
 
-        result += *s;
-
-        prev = s;
-        s++;
+      template<typename _T>
+      _T* allocate(size_t count)
+      {
+        return static_cast<_T*>(allocate(count * sizeof(_T), sizeof(_T) < sizeof(void*) ? sizeof(_T) : sizeof(void*)));
       }
-      while(*s != 0);
 
-      return result;
-    }
+      /* Copy length bytes into the arena and NUL-terminate them */
+      char* copy(const char* s, size_t length)
+      {
+        char* p = static_cast<char*>(allocate(length + 1, 1));
+        memcpy(p, s, length);
+        p[length] = '\0';
+        return p;
+      }
 
-    inline Value* parseMap(char*& s)
-    {
-      Object::MapType result;
+      /* Take over every block of other, which is left empty */
+      void splice(Arena& other)
+      {
+        if (!other.head)
+          return;
+        Block* tail = other.head;
+        while (tail->next)
+          tail = tail->next;
 
-      chomp(s);
-      if(*s != '{') {
-        fprintf(stderr, "Map parse error, expected '{'. Got: %s\n", s);
-        return NULL;
+        if (head)
+        {
+          tail->next = head->next;
+          head->next = other.head;
+        }
+        else
+        {
+          head = other.head;
+          cursor = other.cursor;
+          limit = other.limit;
+        }
+        other.head = NULL;
+        other.cursor = other.limit = NULL;
       }
-      s++;
 
-      while(1)
+      void clear()
       {
-        std::string field_name;
-        Value* field_value;
+        reset();
+        while (spare)
+        {
+          Block* b = spare;
+          spare = b->next;
+          free(b);
+        }
+      }
 
-        chomp(s);
-        if(*s == '}')
-          break;
+      /* Release everything allocated so far but keep the blocks, which
+         later allocations reuse before asking for new ones */
+      void reset()
+      {
+        while (head)
+        {
+          Block* b = head;
+          head = b->next;
+          b->next = spare;
+          spare = b;
+        }
+        cursor = limit = NULL;
+      }
 
-        field_name = parseCharString(s);
+    private:
+      struct Block
+      {
+        Block* next;
+        size_t size;
+      };
 
-        chomp(s);
-        if(*s != ':') {
-          fprintf(stderr, "Map parse error, expected separator ':'. Got: %s\n", s);
-          return NULL;
-        }
-        s++;
-        field_value = parseGeneric(s);
+      static const size_t MAX_BLOCK = 1 << 20;
 
-        result[field_name] = field_value;
+      void grow(size_t atLeast)
+      {
+        Block** reuse = &spare;
+        while (*reuse && (*reuse)->size < atLeast)
+          reuse = &(*reuse)->next;
 
-        chomp(s);
-        if(*s == ',')
-          s++;
-        else if(*s != '}')
+        Block* b = *reuse;
+        if (b)
+          *reuse = b->next;
+        else
         {
-          fprintf(stderr, "Map parse error, expected ',' or '}'. Got: %s\n", s);
-          return NULL;
+          size_t size = next;
+          if (size < atLeast)
+            size = atLeast;
+          if (next < MAX_BLOCK)
+            next *= 2;
+
+          b = static_cast<Block*>(malloc(sizeof(Block) + size));
+          if (!b)
+            throw std::bad_alloc();
+          b->size = size;
         }
+        b->next = head;
+        head = b;
+        cursor = reinterpret_cast<char*>(b + 1);
+        limit = cursor + b->size;
       }
 
-      chomp(s);
-      if(*s != '}') {
-        fprintf(stderr, "Map parse error, expected '}'. Got: %s\n", s);
-        return NULL;
-      }
-      s++;
+      Block* head;
+      Block* spare;
+      char* cursor;
+      char* limit;
+      size_t next;
 
-      return new Object(result);
-    }
+      Arena(const Arena&);
+      Arena& operator=(const Arena&);
+    };
 
-    inline Value* parseList(char*& s)
+    /* A file mapped into memory and followed by at least one NUL byte,
+       so it can be parsed in place like any other string. The mapping
+       is reserved one page longer than the file, as anonymous zeroed
+       memory, and the file mapped over its start: whatever the file
+       size, the byte after its end is a readable NUL. Without mmap the
+       file is read into a heap buffer instead. */
+    class MappedFile
     {
-      Array::VectorType result;
-
-      chomp(s);
-      if(*s != '[') {
-        fprintf(stderr, "List parse error, expected '['. Got: %s\n", s);
-        return NULL;
-      }
-      s++;
+    public:
+      MappedFile() : base(NULL), reserved(0), length(0) {}
+      ~MappedFile() { close(); }
 
-      while(1)
+      /* writable gives a private copy of the file for parsing in situ */
+      bool open(const char* path, bool writable = false)
       {
-        chomp(s);
-        if(*s == ']')
-          break;
-
-        Value* value = parseGeneric(s);
-        result.push_back(value);
+        close();
+#if defined(JSONPARSER_MMAP)
+        int fd = ::open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+          if (fd >= 0)
+            ::close(fd);
+          return fail(E_IO, NULL);
+        }
 
-        chomp(s);
+        size_t size = (size_t) st.st_size;
+        size_t page = (size_t) sysconf(_SC_PAGESIZE);
+        size_t total = (size / page + 1) * page;
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* p = mmap(NULL, total, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED && size)
+        {
+          int flags = MAP_PRIVATE | MAP_FIXED;
+#if defined(MAP_POPULATE)
+          flags |= MAP_POPULATE;
+#endif
+          if (mmap(p, size, prot, flags, fd, 0) == MAP_FAILED)
+          {
+            munmap(p, total);
+            p = MAP_FAILED;
+          }
+#if defined(MADV_SEQUENTIAL)
+          else
+            madvise(p, size, MADV_SEQUENTIAL);
+#endif
+        }
+        ::close(fd);
+        if (p == MAP_FAILED)
+        {
+          return fail(E_IO, NULL);
+        }
 
-        if(*s == ',')
-          s++;
-        else if(*s != ']')
+        base = static_cast<char*>(p);
+        reserved = total;
+        length = size;
+        return true;
+#else
+        (void) writable;
+        FILE* f = fopen(path, "rb");
+        if (!f)
         {
-          fprintf(stderr, "List parse error, expected separator ','. Got: %s\n", s);
-          return NULL;
+          return fail(E_IO, NULL);
+        }
+        std::vector<char> contents;
+        char chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+          contents.insert(contents.end(), chunk, chunk + n);
+        bool failed = ferror(f) != 0;
+        fclose(f);
+        if (failed)
+        {
+          return fail(E_IO, NULL);
         }
+
+        base = static_cast<char*>(malloc(contents.size() + 1));
+        if (!base)
+          throw std::bad_alloc();
+        if (!contents.empty())
+          memcpy(base, &contents[0], contents.size());
+        base[contents.size()] = '\0';
+        length = contents.size();
+        return true;
+#endif
       }
 
-      chomp(s);
-      if(*s != ']') {
-        fprintf(stderr, "List parse error, expected ']'. Got: %s\n", s);
-        return NULL;
+      void close()
+      {
+#if defined(JSONPARSER_MMAP)
+        if (base)
+          munmap(base, reserved);
+#else
+        free(base);
+#endif
+        base = NULL;
+        reserved = length = 0;
       }
-      s++;
 
-      return new Array(result);
+      char* data() const { return base; }
+      size_t size() const { return length; }
+
+    private:
+      char* base;
+      size_t reserved;
+      size_t length;
+
+      MappedFile(const MappedFile&);
+      MappedFile& operator=(const MappedFile&);
+    };
+
+
+    /* FNV-1a hash of an object key */
+    inline uint32_t hashKey(const char* key, size_t length)
+    {
+      uint32_t h = 2166136261u;
+      for (size_t ii = 0 ; ii < length ; ii++)
+        h = (h ^ (unsigned char) key[ii]) * 16777619u;
+      return h;
     }
 
-    inline Value* parseString(char*& s)
+    /* Number of slots in the hash index of an object with count members:
+       a power of two, at most half full */
+    inline size_t hashCapacity(size_t count)
     {
-      std::string chars = parseCharString(s);
-      return new String(chars);
+      size_t capacity = 16;
+      while (capacity < count * 2)
+        capacity *= 2;
+      return capacity;
     }
 
-    static Value* parseLiteral(char*& s)
+#if defined(JSONPARSER_CXX11)
+    typedef std::mutex Mutex;
+#else
+    class Mutex
     {
-      Value* result = NULL;
+    public:
+      Mutex() { pthread_mutex_init(&m, NULL); }
+      ~Mutex() { pthread_mutex_destroy(&m); }
+      void lock() { pthread_mutex_lock(&m); }
+      void unlock() { pthread_mutex_unlock(&m); }
+    private:
+      pthread_mutex_t m;
+      Mutex(const Mutex&);
+      Mutex& operator=(const Mutex&);
+    };
+#endif
 
-      char *tok_start = s;
-      char* tok_end;
-      char* tok;
-      int tok_size;
+    class Lock
+    {
+    public:
+      Lock(Mutex& in) : m(in) { m.lock(); }
+      ~Lock() { m.unlock(); }
+    private:
+      Mutex& m;
+      Lock(const Lock&);
+      Lock& operator=(const Lock&);
+    };
 
-      chomp(s);
+    inline bool unescape(const char* s, const char* end, char* out, size_t& length);
 
-      // s starts with - or a digit
-      if(isdigit(*s) || *s == '-') {
-        do {
-          tok_end = s+1;
-          s++;
-        } while(isdigit(*s) || *s == '-' || *s == '.');
-        tok_size = tok_end - tok_start;
-        tok = new char[tok_size + 1];
-        memcpy(tok, tok_start, tok_size);
-        tok[tok_size] = '\0';
-        result = new Number(atof(tok));
-        delete[] tok;
-      }
-      // alpha
-      else if(isalpha(*s)) {
-        do {
-          tok_end = s+1;
-          s++;
-        } while(isalnum(*s) || *s == '_');
-        tok_size = tok_end - tok_start;
-        tok = new char[tok_size + 1];
-        memcpy(tok, tok_start, tok_size);
-        tok[tok_size] = '\0';
-        if(strcmp(tok, "true") == 0) {
-          result = new Boolean(true);
-        }
-        else if(strcmp(tok, "false") == 0) {
-          result = new Boolean(false);
-        }
-        else {
-          fprintf(stderr, "Unrecognized literal: %s\n", s);
-        }
-      }
-      else {
-        fprintf(stderr, "Unrecognized literal: %s\n", s);
-      }
+  };
 
-      return result;
-    }
+  /* A reference to a run of characters owned by someone else. A string
+     parsed without copying may still contain escape sequences: then
+     escaped() is true, data() holds the raw JSON text, and str()
+     decodes it. */
+  struct StringRef
+  {
+    const char* v;
+    size_t n;
+    bool e;
+    StringRef() : v(""), n(0), e(false) {}
+    StringRef(const char* in, size_t length, bool escaped = false)
+      : v(in), n(length), e(escaped) {}
 
-    inline Value* parseGeneric(char*& s)
+    const char* data() const { return v; }
+    size_t size() const { return n; }
+    bool escaped() const { return e; }
+
+    std::string str() const
     {
-      chomp(s);
-      if(*s == '{') {
-        return parseMap(s);
-      }
-      else if(*s == '[') {
-        return parseList(s);
-      }
-      else if(*s == '\"') {
-        return parseString(s);
-      }
-      else {
-        return parseLiteral(s);
-      }
+      if (!e)
+        return std::string(v, n);
+
+      std::string out(n, '\0');
+      size_t length = 0;
+      impl::unescape(v, v + n, &out[0], length);
+      out.resize(length);
+      return out;
     }
 
-    void formatGeneric(const Value* obj, std::stringstream& out);
+#if defined(JSONPARSER_CXX17)
+    operator std::string_view() const { return std::string_view(v, n); }
+#endif
 
-    inline void formatNumber(const Number* num, std::stringstream& out)
+    bool operator==(const StringRef& other) const
     {
-      out << num->value();
+      return n == other.n && memcmp(v, other.v, n) == 0;
     }
+    bool operator!=(const StringRef& other) const { return !(*this == other); }
+  };
 
-    inline std::string escape(std::string const &s)
-    {
-      std::size_t n = s.length();
-      std::string escaped;
-      escaped.reserve(n * 2);        // pessimistic preallocation
+  /* A key interned by a KeyTable: the table's canonical copy of some key
+     bytes and their hash. Two keys interned by the same table are equal
+     exactly when their data() pointers are. data() is NULL if the table
+     was full. */
+  class InternedKey
+  {
+  public:
+    InternedKey() : v(NULL), n(0), h(0) {}
 
-      for (std::size_t ii = 0; ii < n; ++ii) {
-        if (s[ii] == '\\' || s[ii] == '\"')
-          escaped += '\\';
-        escaped += s[ii];
-      }
-      return escaped;
-    }
+    const char* data() const { return v; }
+    size_t size() const { return n; }
+    uint32_t hash() const { return h; }
 
-    inline void formatString(const std::string& str, std::stringstream& out) 
-    {
-      out << "\"" << escape(str) << "\"";
-    }
+  private:
+    InternedKey(const char* in, uint32_t length, uint32_t hash) : v(in), n(length), h(hash) {}
 
-    inline void formatString(const String* str, std::stringstream& out)
+    const char* v;
+    uint32_t n;
+    uint32_t h;
+
+    friend class KeyTable;
+  };
+
+  /* An object key and its hash, for a key that is looked up over and
+     over: dom::Object finds it in a large object with one probe of its
+     hash index and one memcmp. With C++11 a Key is constexpr, so the
+     hash of a literal is computed by the compiler:
+
+       static constexpr Json::Key HOST("host");
+       const Json::dom::Node* host = headers.get(HOST);
+
+     and with C++20 dom::Object also takes the literal itself, as in
+     headers.get<"host">(). A Key refers to the characters it was made
+     from, which must outlive it. */
+  class Key
+  {
+  public:
+#if defined(JSONPARSER_CXX11)
+    constexpr explicit Key(const char* s) : v(s), n(lengthOf(s, 0)), h(hashOf(s, lengthOf(s, 0), BASIS)) {}
+    constexpr Key(const char* s, size_t length) : v(s), n(length), h(hashOf(s, length, BASIS)) {}
+#else
+    explicit Key(const char* s) : v(s), n(strlen(s)), h(impl::hashKey(s, n)) {}
+    Key(const char* s, size_t length) : v(s), n(length), h(impl::hashKey(s, length)) {}
+#endif
+    explicit Key(const std::string& s) : v(s.data()), n(s.size()), h(impl::hashKey(v, n)) {}
+#if defined(JSONPARSER_CXX17)
+    explicit Key(std::string_view s) : v(s.data()), n(s.size()), h(impl::hashKey(v, n)) {}
+#endif
+
+    JSONPARSER_CONSTEXPR const char* data() const { return v; }
+    JSONPARSER_CONSTEXPR size_t size() const { return n; }
+    JSONPARSER_CONSTEXPR uint32_t hash() const { return h; }
+
+  private:
+    const char* v;
+    size_t n;
+    uint32_t h;
+
+#if defined(JSONPARSER_CXX11)
+    static const uint32_t BASIS = 2166136261u;
+
+    /* strlen and impl::hashKey, written for C++11 constant expressions */
+    static constexpr size_t lengthOf(const char* s, size_t length)
     {
-      formatString(str->value(), out);
+      return s[length] ? lengthOf(s, length + 1) : length;
     }
 
-    inline void formatBoolean(const Boolean* bo, std::stringstream& out)
+    static constexpr uint32_t hashOf(const char* s, size_t length, uint32_t h)
     {
-      out << (bo->value() ? "true" : "false");
+      return length ? hashOf(s + 1, length - 1, (h ^ (unsigned char) *s) * 16777619u) : h;
     }
+#endif
+  };
 
-    inline void formatArray(const Array* arr, std::stringstream& out)
-    {
-      out << "[";
+#if defined(JSONPARSER_CXX20)
+  namespace impl {
 
-      for(size_t ii = 0 ; ii < arr->size() ; ++ii)
+    /* A string literal passed as a template argument, for
+       dom::Object::get<"key">() */
+    template<size_t N>
+    struct KeyLiteral
+    {
+      char s[N];
+      constexpr KeyLiteral(const char (&in)[N])
       {
-        if(ii > 0) out << ", ";
-        const Value* entry = arr->get(ii);
-        formatGeneric(entry, out);
+        for (size_t ii = 0 ; ii < N ; ii++)
+          s[ii] = in[ii];
       }
+    };
 
-      out << "]";
-    }
+  }; // namespace
+#endif
 
-    inline void formatObject(const Object* obj, std::stringstream& out)
+  /* A thread-safe table of object keys, shared by any number of
+     Documents. A Document parsed with a KeyTable attached stores its
+     keys as pointers into the table instead of copying each one, and
+     dom::Object can then match an InternedKey by pointer. Interned keys
+     are never released before the table itself, so it should outlive
+     every Document using it. maxKeys, if nonzero, bounds the number of
+     distinct keys: once it is reached new keys are copied as usual. */
+  class KeyTable
+  {
+  public:
+    KeyTable(size_t maxKeys = 0)
+      : shardLimit(maxKeys ? (maxKeys + SHARDS - 1) / SHARDS : 0) {}
+
+    InternedKey intern(const char* key, size_t length)
     {
-      out << "{";
+      if (length > 0xffffffffu)
+        return InternedKey();
 
-      Object::KeySet keys = obj->keys();
-      bool first = true;
-      for(Object::KeySet::iterator it = keys.begin() ; it != keys.end() ; it++)
+      uint32_t h = impl::hashKey(key, length);
+      Shard& shard = shards[h >> (32 - SHARD_BITS)];
+      impl::Lock lock(shard.mutex);
+
+      size_t mask = shard.slots.size() - 1;
+      size_t slot = h & mask;
+      for (const char* e ; shard.slots.size() && (e = shard.slots[slot]) != NULL ; slot = (slot + 1) & mask)
       {
-        if (!first) out << ", ";
-        const std::string& key = *it;
-        formatString(key, out);
-        out << " : ";
-        const Value* entry = obj->get(key);
-        formatGeneric(entry, out);
-        first = false;
+        if (hashOf(e) == h && lengthOf(e) == length && memcmp(e, key, length) == 0)
+          return InternedKey(e, (uint32_t) length, h);
       }
 
-      out << "}";
+      if (shardLimit && shard.count >= shardLimit)
+        return InternedKey();
+
+      if ((shard.count + 1) * 2 > shard.slots.size())
+      {
+        rehash(shard);
+        mask = shard.slots.size() - 1;
+        for (slot = h & mask ; shard.slots[slot] ; slot = (slot + 1) & mask) ;
+      }
+
+      /* Entries are [hash][length][bytes]\0 */
+      char* e = static_cast<char*>(shard.arena.allocate(2 * sizeof(uint32_t) + length + 1, sizeof(uint32_t)));
+      uint32_t header[2] = { h, (uint32_t) length };
+      memcpy(e, header, sizeof(header));
+      e += sizeof(header);
+      memcpy(e, key, length);
+      e[length] = '\0';
+
+      shard.slots[slot] = e;
+      shard.count++;
+      return InternedKey(e, (uint32_t) length, h);
     }
 
-    inline void formatGeneric(const Value* obj, std::stringstream& out)
+    InternedKey intern(const std::string& key)
     {
-      if (!obj)
+      return intern(key.data(), key.size());
+    }
+
+    /* Number of distinct keys interned so far */
+    size_t size()
+    {
+      size_t total = 0;
+      for (size_t ii = 0 ; ii < SHARDS ; ii++)
       {
-        out << "null";
-        return;
+        impl::Lock lock(shards[ii].mutex);
+        total += shards[ii].count;
       }
+      return total;
+    }
 
-      switch(obj->getType())
+  private:
+    /* Keys are spread over independently locked shards by the top bits
+       of their hash, so threads parsing at once rarely wait on each
+       other */
+    static const size_t SHARD_BITS = 4;
+    static const size_t SHARDS = 1 << SHARD_BITS;
+
+    struct Shard
+    {
+      impl::Mutex mutex;
+      impl::Arena arena;
+      std::vector<const char*> slots;
+      size_t count;
+      Shard() : count(0) {}
+    };
+
+    Shard shards[SHARDS];
+    size_t shardLimit;
+
+    static uint32_t hashOf(const char* e)
+    {
+      uint32_t h;
+      memcpy(&h, e - 2 * sizeof(uint32_t), sizeof(h));
+      return h;
+    }
+
+    static uint32_t lengthOf(const char* e)
+    {
+      uint32_t n;
+      memcpy(&n, e - sizeof(uint32_t), sizeof(n));
+      return n;
+    }
+
+    static void rehash(Shard& shard)
+    {
+      std::vector<const char*> slots(shard.slots.empty() ? 64 : shard.slots.size() * 2, (const char*) NULL);
+      size_t mask = slots.size() - 1;
+      for (size_t ii = 0 ; ii < shard.slots.size() ; ii++)
+      {
+        const char* e = shard.slots[ii];
+        if (!e)
+          continue;
+        size_t slot = hashOf(e) & mask;
+        while (slots[slot])
+          slot = (slot + 1) & mask;
+        slots[slot] = e;
+      }
+      shard.slots.swap(slots);
+    }
+
+    KeyTable(const KeyTable&);
+    KeyTable& operator=(const KeyTable&);
+  };
+
+  /* Nodes of a Document. A Node is a 16-byte tagged value: numbers and
+     booleans are stored inline, strings and containers as a pointer and
+     a length into the Document's Arena. Type checks are plain integer
+     compares, and array elements and object members are stored
+     contiguously rather than behind one pointer per child. */
+  namespace dom {
+    class Node;
+  };
+
+  namespace impl {
+
+    class DocumentBuilder;
+
+    /* A container that has not been parsed yet: its text from the
+       opening bracket to past the closing one, and the builder of the
+       Document it belongs to */
+    struct LazyRange
+    {
+      char* begin;
+      char* end;
+      DocumentBuilder* builder;
+    };
+
+    inline bool materialize(dom::Node& node);
+
+  }; // namespace
+
+  namespace dom {
+
+    class Array;
+    class Object;
+    struct Member;
+
+    class Node
+    {
+    public:
+      /* The longest string, array or object a Node can hold */
+      static const size_t MAX_LENGTH = 0xffffffffu;
+
+      Node() : tag(T_NULL), flags(0), length(0) { payload.number = 0; }
+
+      static Node makeNull() { return Node(); }
+
+      static Node makeNumber(double in)
+      {
+        Node node(T_NUMBER, 0);
+        node.payload.number = in;
+        return node;
+      }
+
+      static Node makeInt64(int64_t in)
+      {
+        Node node(T_NUMBER, N_INT64);
+        node.payload.i = in;
+        return node;
+      }
+
+      static Node makeUInt64(uint64_t in)
+      {
+        Node node(T_NUMBER, N_UINT64);
+        node.payload.u = in;
+        return node;
+      }
+
+      static Node makeBoolean(bool in)
+      {
+        return Node(T_BOOLEAN, in ? 1 : 0);
+      }
+
+      /* escaped marks raw JSON text that still has to be decoded */
+      static Node makeString(const char* in, size_t size, bool escaped = false)
+      {
+        Node node(T_STRING, size);
+        node.payload.chars = in;
+        node.flags = escaped ? F_ESCAPED : 0;
+        return node;
+      }
+
+      /* An object key held by a KeyTable */
+      static Node makeKey(const InternedKey& key)
+      {
+        Node node(T_STRING, key.size());
+        node.payload.chars = key.data();
+        node.flags = F_INTERNED;
+        return node;
+      }
+
+      static Node makeArray(const Node* in, size_t count)
+      {
+        Node node(T_ARRAY, count);
+        node.payload.items = in;
+        return node;
+      }
+
+      /* indexed marks members followed by a hash index, see Object */
+      static Node makeObject(const Member* in, size_t count, bool indexed = false)
+      {
+        Node node(T_OBJECT, count);
+        node.payload.members = in;
+        node.flags = indexed ? F_INDEXED : 0;
+        return node;
+      }
+
+      /* A container of type t whose text has only been stepped over.
+         It is parsed by the first view made of it. */
+      static Node makeLazy(Type t, const impl::LazyRange* range)
+      {
+        Node node(t, 0);
+        node.payload.range = range;
+        node.flags = F_LAZY;
+        return node;
+      }
+
+      Type getType() const { return (Type) tag; }
+      bool isNull() const { return tag == T_NULL; }
+
+      /* Unchecked accessors; the caller has already looked at getType() */
+      double number() const
+      {
+        return length == N_DOUBLE ? payload.number
+          : length == N_INT64 ? (double) payload.i : (double) payload.u;
+      }
+      NumberKind numberKind() const { return (NumberKind) length; }
+      int64_t int64() const { return payload.i; }
+      uint64_t uint64() const { return payload.u; }
+      bool boolean() const { return length != 0; }
+      StringRef string() const { return StringRef(payload.chars, length, (flags & F_ESCAPED) != 0); }
+
+      /* Checked accessors. Each returns true if this node holds a value
+         of the requested type and stores it in out. */
+      bool as(double& out) const
+      {
+        if (tag != T_NUMBER) return false;
+        out = number();
+        return true;
+      }
+
+      /* Succeeds for numbers whose value is exactly an int64_t */
+      bool as(int64_t& out) const
+      {
+        if (tag != T_NUMBER) return false;
+        if (length == N_INT64)
+          out = payload.i;
+        else if (length == N_UINT64 || !(payload.number >= -9223372036854775808.0
+                                         && payload.number < 9223372036854775808.0)
+                 || payload.number != (double) (int64_t) payload.number)
+          return false;
+        else
+          out = (int64_t) payload.number;
+        return true;
+      }
+
+      /* Succeeds for numbers whose value is exactly a uint64_t */
+      bool as(uint64_t& out) const
+      {
+        if (tag != T_NUMBER) return false;
+        if (length == N_UINT64)
+          out = payload.u;
+        else if (length == N_INT64) {
+          if (payload.i < 0) return false;
+          out = (uint64_t) payload.i;
+        }
+        else if (!(payload.number >= 0 && payload.number < 18446744073709551616.0)
+                 || payload.number != (double) (uint64_t) payload.number)
+          return false;
+        else
+          out = (uint64_t) payload.number;
+        return true;
+      }
+
+      bool as(bool& out) const
+      {
+        if (tag != T_BOOLEAN) return false;
+        out = length != 0;
+        return true;
+      }
+
+      bool as(StringRef& out) const
+      {
+        if (tag != T_STRING) return false;
+        out = string();
+        return true;
+      }
+
+      bool as(std::string& out) const
+      {
+        if (tag != T_STRING) return false;
+        if (flags & F_ESCAPED)
+          out = string().str();
+        else
+          out.assign(payload.chars, length);
+        return true;
+      }
+
+      bool as(const Node*& out) const
+      {
+        out = this;
+        return true;
+      }
+
+      inline bool as(Array& out) const;
+      inline bool as(Object& out) const;
+
+    private:
+      Node(Type t, size_t size) : tag((uint16_t) t), flags(0), length((uint32_t) size) {}
+
+      enum
+      {
+        F_ESCAPED = 1,
+        F_INDEXED = 2,
+        F_INTERNED = 4,
+        F_LAZY = 8
+      };
+
+      friend class Array;
+      friend class Object;
+      friend bool impl::materialize(Node& node);
+
+      union
+      {
+        double number;
+        int64_t i;
+        uint64_t u;
+        const char* chars;
+        const Node* items;
+        const Member* members;
+        const impl::LazyRange* range;
+      } payload;
+      uint16_t tag;
+      uint16_t flags;
+      uint32_t length;
+    };
+
+    struct Member
+    {
+      Node key;
+      Node value;
+    };
+
+    /* Typed view of an array Node */
+    class Array
+    {
+    public:
+      Array() : node(NULL) {}
+      Array(const Node& in) : node(&in)
+      {
+        if (in.flags & Node::F_LAZY)
+          impl::materialize(const_cast<Node&>(in));
+      }
+
+      size_t size() const { return node ? node->length : 0; }
+
+      const Node* get(size_t idx) const
+      {
+        return &node->payload.items[idx];
+      }
+
+      const Node& operator[](size_t idx) const { return *get(idx); }
+
+      template<typename _T>
+      bool get(size_t idx, _T& out) const
+      {
+        return get(idx)->as(out);
+      }
+
+      static const Type TYPE = T_ARRAY;
+
+    private:
+      const Node* node;
+    };
+
+    /* Typed view of an object Node. Members are stored contiguously and
+       small objects are searched linearly. Objects with more than
+       HASH_THRESHOLD members are followed in memory by an open-addressing
+       table of member indices, hashCapacity(size()) slots long. */
+    class Object
+    {
+    public:
+      Object() : node(NULL) {}
+      Object(const Node& in) : node(&in)
+      {
+        if (in.flags & Node::F_LAZY)
+          impl::materialize(const_cast<Node&>(in));
+      }
+
+      /* Members in document order, or sorted by key with P_SORTED_KEYS */
+      size_t size() const { return node ? node->length : 0; }
+      const Member& member(size_t idx) const { return node->payload.members[idx]; }
+
+      /* Look up a member by key. Duplicate keys resolve to the last
+         occurrence, as they do for Json::Object. */
+      const Node* find(const char* key, size_t length) const
+      {
+        if (node->flags & Node::F_INDEXED)
+          return probe(impl::hashKey(key, length), key, length);
+        return scan(key, length);
+      }
+
+      /* Look up a member by a Key, whose hash is already known */
+      const Node* get(const Key& key) const
+      {
+        if (node->flags & Node::F_INDEXED)
+          return probe(key.hash(), key.data(), key.size());
+        return scan(key.data(), key.size());
+      }
+
+      /* Look up a member by a key from the KeyTable the Document was
+         parsed with. Interned member keys are compared by pointer and
+         large objects are probed with the key's stored hash. */
+      const Node* get(const InternedKey& key) const
+      {
+        const Member* v = node->payload.members;
+        if (!key.data())
+          return NULL;
+
+        if (node->flags & Node::F_INDEXED)
+        {
+          const uint32_t* index = reinterpret_cast<const uint32_t*>(v + size());
+          size_t mask = impl::hashCapacity(size()) - 1;
+          for (size_t slot = key.hash() & mask ; index[slot] != EMPTY ; slot = (slot + 1) & mask)
+          {
+            const Member& m = v[index[slot]];
+            if ((m.key.flags & Node::F_INTERNED) ? m.key.payload.chars == key.data()
+                : matches(m.key, key.data(), key.size()))
+              return &m.value;
+          }
+          return NULL;
+        }
+
+        for (size_t ii = size() ; ii-- > 0 ; )
+        {
+          const Node& k = v[ii].key;
+          if ((k.flags & Node::F_INTERNED) ? k.payload.chars == key.data()
+              : matches(k, key.data(), key.size()))
+            return &v[ii].value;
+        }
+        return NULL;
+      }
+
+      const Node* get(const std::string& key) const
+      {
+        return find(key.data(), key.size());
+      }
+
+      const Node* get(const char* key) const
+      {
+        return find(key, strlen(key));
+      }
+
+#if defined(JSONPARSER_CXX17)
+      const Node* get(std::string_view key) const
+      {
+        return find(key.data(), key.size());
+      }
+#endif
+
+#if defined(JSONPARSER_CXX20)
+      template<impl::KeyLiteral _K>
+      const Node* get() const
+      {
+        static constexpr Key key(_K.s, sizeof(_K.s) - 1);
+        return get(key);
+      }
+
+      template<impl::KeyLiteral _K, typename _T>
+      bool get(_T& out) const
+      {
+        const Node* e = get<_K>();
+        return e && e->as(out);
+      }
+#endif
+
+      template<typename _T>
+      bool get(const std::string& key, _T& out) const
+      {
+        const Node* e = get(key);
+        return e && e->as(out);
+      }
+
+      template<typename _T>
+      bool get(const char* key, _T& out) const
+      {
+        const Node* e = get(key);
+        return e && e->as(out);
+      }
+
+      template<typename _T>
+      bool get(const InternedKey& key, _T& out) const
+      {
+        const Node* e = get(key);
+        return e && e->as(out);
+      }
+
+      template<typename _T>
+      bool get(const Key& key, _T& out) const
+      {
+        const Node* e = get(key);
+        return e && e->as(out);
+      }
+
+#if defined(JSONPARSER_CXX17)
+      template<typename _T>
+      bool get(std::string_view key, _T& out) const
+      {
+        const Node* e = get(key);
+        return e && e->as(out);
+      }
+#endif
+
+      static const Type TYPE = T_OBJECT;
+      static const size_t HASH_THRESHOLD = 16;
+      static const uint32_t EMPTY = 0xffffffffu;
+
+    private:
+      const Node* node;
+
+      /* Search the hash index of a large object */
+      const Node* probe(uint32_t hash, const char* key, size_t length) const
+      {
+        const Member* v = node->payload.members;
+        const uint32_t* index = reinterpret_cast<const uint32_t*>(v + size());
+        size_t mask = impl::hashCapacity(size()) - 1;
+        for (size_t slot = hash & mask ; index[slot] != EMPTY ; slot = (slot + 1) & mask)
+        {
+          const Member& m = v[index[slot]];
+          if (m.key.length == length && memcmp(m.key.payload.chars, key, length) == 0)
+            return &m.value;
+        }
+        return NULL;
+      }
+
+      /* Search a small object from its last member back */
+      const Node* scan(const char* key, size_t length) const
+      {
+        const Member* v = node->payload.members;
+        for (size_t ii = size() ; ii-- > 0 ; )
+        {
+          if (matches(v[ii].key, key, length))
+            return &v[ii].value;
+        }
+        return NULL;
+      }
+
+      static bool matches(const Node& k, const char* key, size_t length)
+      {
+        if (k.flags & Node::F_ESCAPED)
+          return k.string().str() == std::string(key, length);
+        return k.length == length && memcmp(k.payload.chars, key, length) == 0;
+      }
+    };
+
+    inline bool Node::as(Array& out) const
+    {
+      if (tag != T_ARRAY) return false;
+      out = Array(*this);
+      return tag == T_ARRAY;
+    }
+
+    inline bool Node::as(Object& out) const
+    {
+      if (tag != T_OBJECT) return false;
+      out = Object(*this);
+      return tag == T_OBJECT;
+    }
+
+  }; // namespace
+
+
+  namespace impl {
+
+    inline int trailingZeros(uint64_t bits)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+      unsigned long idx;
+      _BitScanForward64(&idx, bits);
+      return (int) idx;
+#elif defined(_MSC_VER)
+      unsigned long idx;
+      if (_BitScanForward(&idx, (unsigned long) bits))
+        return (int) idx;
+      _BitScanForward(&idx, (unsigned long) (bits >> 32));
+      return (int) idx + 32;
+#else
+      return __builtin_ctzll(bits);
+#endif
+    }
+
+    /* Whitespace as classified by isspace() in the C locale */
+    inline bool isSpace(char c)
+    {
+      return c == ' ' || (unsigned char) (c - 9) <= 4;
+    }
+
+#if defined(JSONPARSER_SSE2)
+    inline __m128i spaceMask(__m128i c)
+    {
+      __m128i ctrl = _mm_sub_epi8(c, _mm_set1_epi8(9));
+      return _mm_or_si128(
+        _mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+        _mm_cmpeq_epi8(_mm_min_epu8(ctrl, _mm_set1_epi8(4)), ctrl));
+    }
+#endif
+
+    /* Skip a run of whitespace, 16 bytes at a time where possible */
+    JSONPARSER_NO_SANITIZE inline char* skipSpace(char* s)
+    {
+#if defined(JSONPARSER_SSE2)
+      const char* block = (const char*) ((uintptr_t) s & ~(uintptr_t) 15);
+      unsigned int stop = ~_mm_movemask_epi8(spaceMask(_mm_load_si128((const __m128i*) block)));
+      stop &= 0xffffu << (s - block);
+      while (!(stop & 0xffff))
+      {
+        block += 16;
+        stop = ~_mm_movemask_epi8(spaceMask(_mm_load_si128((const __m128i*) block)));
+      }
+      return (char*) block + trailingZeros(stop);
+#else
+      while (isSpace(*s))
+        ++s;
+      return s;
+#endif
+    }
+
+    /* Find the end of the line s is on: its '\n' or the terminating NUL */
+    JSONPARSER_NO_SANITIZE inline char* skipLine(char* s)
+    {
+#if defined(JSONPARSER_SSE2)
+      const char* block = (const char*) ((uintptr_t) s & ~(uintptr_t) 15);
+      __m128i c = _mm_load_si128((const __m128i*) block);
+      unsigned int stop = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(c, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(c, _mm_setzero_si128())));
+      stop &= 0xffffu << (s - block);
+      while (!stop)
+      {
+        block += 16;
+        c = _mm_load_si128((const __m128i*) block);
+        stop = _mm_movemask_epi8(_mm_or_si128(
+          _mm_cmpeq_epi8(c, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(c, _mm_setzero_si128())));
+      }
+      return (char*) block + trailingZeros(stop);
+#else
+      while (*s != '\n' && *s != 0)
+        ++s;
+      return s;
+#endif
+    }
+
+    inline bool chompComment(char*& s)
+    {
+      if (*(s) == '/' && *(s + 1) == '/')
+      {
+        s = skipLine(s + 2);
+        return true;
+      }
+      return false;
+    }
+
+    inline bool chompSpace(char*& s)
+    {
+      if (isSpace(*s))
+      {
+        ++s;
+        if (isSpace(*s))
+          s = skipSpace(s);
+        return true;
+      }
+      return false;
+    }
+
+    inline void chomp(char*& s)
+    {
+      while (chompSpace(s) || chompComment(s))
+        ;
+    }
+
+    /* Find the first '"', '\\' or terminating NUL at or after s */
+    JSONPARSER_NO_SANITIZE inline char* findQuoteOrEscape(char* s)
+    {
+#if defined(JSONPARSER_SSE2)
+      const char* block = (const char*) ((uintptr_t) s & ~(uintptr_t) 15);
+      __m128i c = _mm_load_si128((const __m128i*) block);
+      unsigned int stop = _mm_movemask_epi8(_mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('"')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))),
+        _mm_cmpeq_epi8(c, _mm_setzero_si128())));
+      stop &= 0xffffu << (s - block);
+      while (!stop)
+      {
+        block += 16;
+        c = _mm_load_si128((const __m128i*) block);
+        stop = _mm_movemask_epi8(_mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('"')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))),
+          _mm_cmpeq_epi8(c, _mm_setzero_si128())));
+      }
+      return (char*) block + trailingZeros(stop);
+#else
+      while (*s != '"' && *s != '\\' && *s != 0)
+        ++s;
+      return s;
+#endif
+    }
+
+    inline int hexValue(char c)
+    {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+    }
+
+    inline bool parseHex4(const char* s, uint32_t& out)
+    {
+      out = 0;
+      for (int ii = 0 ; ii < 4 ; ii++)
+      {
+        int digit = hexValue(s[ii]);
+        if (digit < 0)
+          return false;
+        out = (out << 4) | digit;
+      }
+      return true;
+    }
+
+    inline void encodeUtf8(uint32_t cp, char*& out)
+    {
+      if (cp < 0x80) {
+        *out++ = (char) cp;
+      }
+      else if (cp < 0x800) {
+        *out++ = (char) (0xc0 | (cp >> 6));
+        *out++ = (char) (0x80 | (cp & 0x3f));
+      }
+      else if (cp < 0x10000) {
+        *out++ = (char) (0xe0 | (cp >> 12));
+        *out++ = (char) (0x80 | ((cp >> 6) & 0x3f));
+        *out++ = (char) (0x80 | (cp & 0x3f));
+      }
+      else {
+        *out++ = (char) (0xf0 | (cp >> 18));
+        *out++ = (char) (0x80 | ((cp >> 12) & 0x3f));
+        *out++ = (char) (0x80 | ((cp >> 6) & 0x3f));
+        *out++ = (char) (0x80 | (cp & 0x3f));
+      }
+    }
+
+    /* Decode the escape sequence at s, which points just past its
+       backslash. A lone surrogate decodes to U+FFFD. Never writes more
+       bytes than it consumes, counting the backslash. */
+    inline bool decodeEscape(const char*& s, const char* end, char*& out)
+    {
+      switch (*s++)
+      {
+      case '"': *out++ = '"'; return true;
+      case '\\': *out++ = '\\'; return true;
+      case '/': *out++ = '/'; return true;
+      case 'b': *out++ = '\b'; return true;
+      case 'f': *out++ = '\f'; return true;
+      case 'n': *out++ = '\n'; return true;
+      case 'r': *out++ = '\r'; return true;
+      case 't': *out++ = '\t'; return true;
+      case 'u':
+        {
+          uint32_t cp;
+          if (end - s < 4 || !parseHex4(s, cp))
+            return false;
+          s += 4;
+          if (cp >= 0xd800 && cp < 0xdc00)
+          {
+            uint32_t low;
+            if (end - s >= 6 && s[0] == '\\' && s[1] == 'u' && parseHex4(s + 2, low)
+                && low >= 0xdc00 && low < 0xe000)
+            {
+              s += 6;
+              cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+            else
+              cp = 0xfffd;
+          }
+          else if (cp >= 0xdc00 && cp < 0xe000)
+            cp = 0xfffd;
+          encodeUtf8(cp, out);
+          return true;
+        }
+      default:
+        return false;
+      }
+    }
+
+    /* Decode the raw contents [s, end) of a string into out, which has
+       room for at least end - s bytes, copying unescaped runs whole.
+       out may be s itself to decode in place. Stores the decoded length
+       in length. */
+    inline bool unescape(const char* s, const char* end, char* out, size_t& length)
+    {
+      char* start = out;
+      while (s < end)
+      {
+        const char* bs = static_cast<const char*>(memchr(s, '\\', end - s));
+        if (!bs)
+          bs = end;
+        memmove(out, s, bs - s);
+        out += bs - s;
+        s = bs;
+        if (s < end)
+        {
+          ++s;
+          if (!decodeEscape(s, end, out))
+            return fail(E_INVALID_ESCAPE, bs);
+        }
+      }
+      length = out - start;
+      return true;
+    }
+
+    /* Check the escape sequences of the raw string contents [s, end)
+       without decoding them */
+    inline bool validEscapes(const char* s, const char* end)
+    {
+      while ((s = static_cast<const char*>(memchr(s, '\\', end - s))) != NULL)
+      {
+        const char* e = s + 1;
+        uint32_t cp;
+        if (e < end && strchr("\"\\/bfnrt", *e) && *e)
+          s = e + 1;
+        else if (e < end && *e == 'u' && end - e > 4 && parseHex4(e + 1, cp))
+          s = e + 5;
+        else
+          return fail(E_INVALID_ESCAPE, s);
+      }
+      return true;
+    }
+
+    /* Scan a quoted string, leaving begin/length pointing at its raw
+       contents within the input. escaped is set if they contain escape
+       sequences that still have to be decoded with unescape(). */
+    inline bool scanCharString(char*& s, const char*& begin, size_t& length, bool& escaped)
+    {
+      chomp(s);
+
+      if(*s != '"')
+        return fail(E_EXPECTED_KEY, s);
+
+      s++;
+      begin = s;
+      escaped = false;
+
+      while(1) {
+        s = findQuoteOrEscape(s);
+        if(*s == '"')
+          break;
+        if(*s == 0 || *(s + 1) == 0)
+          return fail(E_UNTERMINATED_STRING, begin - 1);
+        escaped = true;
+        s += 2;
+      }
+
+      length = s - begin;
+      s++;
+      return true;
+    }
+
+    inline bool isDigit(char c)
+    {
+      return (unsigned char) (c - '0') < 10;
+    }
+
+#if defined(JSONPARSER_STRTOD_L)
+#if defined(_MSC_VER)
+    typedef _locale_t CLocale;
+#else
+    typedef locale_t CLocale;
+#endif
+
+    /* The "C" locale, created once and never freed */
+    inline CLocale cLocale()
+    {
+#if defined(_MSC_VER)
+      static CLocale c = _create_locale(LC_NUMERIC, "C");
+#else
+      static CLocale c = newlocale(LC_NUMERIC_MASK, "C", (locale_t) 0);
+#endif
+      return c;
+    }
+#endif
+
+    /* Convert the number token [begin, end) to the nearest double,
+       whatever the current locale. scale is the power of ten just above
+       the value, which decides between infinity and zero when it is out
+       of range. The locale is never changed, and only the portable
+       fallback allocates, for tokens over a hundred bytes long. */
+    inline double convertNumber(const char* begin, const char* end, int scale)
+    {
+#if defined(JSONPARSER_FROM_CHARS)
+      double v = 0;
+      if (std::from_chars(begin, end, v).ec == std::errc())
+        return v;
+      v = scale > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+      return *begin == '-' ? -v : v;
+#elif defined(JSONPARSER_STRTOD_L)
+      // the character at end cannot continue a number, so strtod stops there
+      (void) end; (void) scale;
+#if defined(_MSC_VER)
+      return _strtod_l(begin, NULL, cLocale());
+#else
+      return strtod_l(begin, NULL, cLocale());
+#endif
+#else
+      /* Rewrite the token without its decimal point, which is the only
+         part the locale changes. Every digit is kept, as the last ones
+         can decide how the value rounds, so a token too long for the
+         buffer on the stack is rewritten on the heap. */
+      (void) scale;
+      char stack[128];
+      std::vector<char> heap;
+      char* buf = stack;
+      size_t size = (end - begin) + 24;
+      if (size > sizeof(stack))
+      {
+        heap.resize(size);
+        buf = &heap[0];
+      }
+      size_t n = 0;
+      long e = 0;
+      bool fraction = false;
+      const char* p = begin;
+      if (*p == '-')
+        buf[n++] = *p++;
+      for ( ; p < end && *p != 'e' && *p != 'E' ; ++p)
+      {
+        if (*p == '.')
+          fraction = true;
+        else if ((n == 0 || buf[n - 1] == '-') && *p == '0')
+          e -= fraction;
+        else
+        {
+          buf[n++] = *p;
+          e -= fraction;
+        }
+      }
+      if (p < end)
+      {
+        bool negative = (*++p == '-');
+        long x = 0;
+        for (p += (*p == '-' || *p == '+') ; p < end ; ++p)
+        {
+          if (x < 100000)
+            x = x * 10 + (*p - '0');
+        }
+        e += negative ? -x : x;
+      }
+      sprintf(buf + n, "e%ld", e);
+      return strtod(buf, NULL);
+#endif
+    }
+
+    /* Convert eight ASCII digits at s at once, or return false if they
+       are not all digits or could not be read without crossing into the
+       next page */
+    JSONPARSER_NO_SANITIZE inline bool parseEightDigits(const char* s, uint32_t& out)
+    {
+#if defined(JSONPARSER_LITTLE_ENDIAN)
+      if (((uintptr_t) s & 4095) > 4096 - 8)
+        return false;
+
+      uint64_t v;
+      memcpy(&v, s, 8);
+      if (((v & 0xf0f0f0f0f0f0f0f0ull)
+           | (((v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) != 0x3333333333333333ull)
+        return false;
+
+      v -= 0x3030303030303030ull;
+      v = (v * 10) + (v >> 8);
+      v = (((v & 0x000000ff000000ffull) * (100 + (1000000ull << 32)))
+           + (((v >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >> 32;
+      out = (uint32_t) v;
+      return true;
+#else
+      (void) s; (void) out;
+      return false;
+#endif
+    }
+
+    /* A parsed number: the nearest double and, for integer literals that
+       fit in 64 bits, the exact value */
+    struct ParsedNumber
+    {
+      double d;
+      NumberKind kind;
+      uint64_t bits;
+    };
+
+    /* Parse a number following the RFC 8259 grammar directly from the
+       input. When the significant digits fit in 53 bits and the decimal
+       exponent is within [-22, 22], both operands of one multiplication
+       or division are exact and the result is correctly rounded; other
+       values fall back to strtod(). Digits are consumed eight at a time
+       while they last. */
+    JSONPARSER_NO_SANITIZE inline bool parseNumber(char*& s, ParsedNumber& out)
+    {
+      char* start = s;
+      bool negative = (*s == '-');
+      uint64_t mantissa = 0;
+      int digits = 0;
+      int exponent = 0;
+      bool truncated = false;
+      bool integer = true;
+      uint32_t eight;
+
+      if (negative)
+        ++s;
+      if (!isDigit(*s))
+        return false;
+
+      if (*s == '0')
+        ++s;
+      else
+      {
+        while (digits <= 11 && parseEightDigits(s, eight))
+        {
+          mantissa = mantissa * 100000000 + eight;
+          digits += 8;
+          s += 8;
+        }
+        for ( ; isDigit(*s) ; ++s)
+        {
+          unsigned int d = *s - '0';
+          if (digits < 19 || (digits == 19 && mantissa <= (~(uint64_t) 0 - d) / 10))
+          {
+            mantissa = mantissa * 10 + d;
+            digits++;
+          }
+          else
+          {
+            exponent++;
+            truncated = true;
+          }
+        }
+      }
+
+      if (*s == '.')
+      {
+        integer = false;
+        ++s;
+        if (!isDigit(*s))
+          return false;
+        while (mantissa != 0 && digits <= 11 && parseEightDigits(s, eight))
+        {
+          mantissa = mantissa * 100000000 + eight;
+          digits += 8;
+          exponent -= 8;
+          s += 8;
+        }
+        for ( ; isDigit(*s) ; ++s)
+        {
+          if (mantissa == 0 && *s == '0')
+            exponent--;
+          else if (digits < 19)
+          {
+            mantissa = mantissa * 10 + (*s - '0');
+            digits++;
+            exponent--;
+          }
+          else
+            truncated = true;
+        }
+      }
+
+      if (*s == 'e' || *s == 'E')
+      {
+        integer = false;
+        ++s;
+        bool negativeExponent = (*s == '-');
+        if (*s == '-' || *s == '+')
+          ++s;
+        if (!isDigit(*s))
+          return false;
+        int e = 0;
+        for ( ; isDigit(*s) ; ++s)
+        {
+          if (e < 100000)
+            e = e * 10 + (*s - '0');
+        }
+        exponent += negativeExponent ? -e : e;
+      }
+
+      out.kind = N_DOUBLE;
+      out.bits = 0;
+      // -0 stays a double so that its sign survives
+      if (integer && !truncated && !(negative && mantissa == 0))
+      {
+        if (!negative)
+        {
+          out.kind = mantissa < ((uint64_t) 1 << 63) ? N_INT64 : N_UINT64;
+          out.bits = mantissa;
+          out.d = (double) mantissa;
+          return true;
+        }
+        else if (mantissa <= ((uint64_t) 1 << 63))
+        {
+          out.kind = N_INT64;
+          out.bits = 0 - mantissa;
+          out.d = -(double) mantissa;
+          return true;
+        }
+      }
+
+      static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1)
+      const bool exactDoubles = true;
+#else
+      const bool exactDoubles = false;  // x87 extended precision would round twice
+#endif
+      if (exactDoubles && !truncated && mantissa <= ((uint64_t) 1 << 53)
+          && exponent >= -22 && exponent <= 22)
+      {
+        double v = (double) mantissa;
+        v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+        out.d = negative ? -v : v;
+        return true;
+      }
+      if (mantissa == 0)
+      {
+        out.d = negative ? -0.0 : 0.0;
+        return true;
+      }
+
+      out.d = convertNumber(start, s, digits + exponent);
+      return true;
+    }
+
+    typedef enum
+    {
+      L_INVALID, L_NUMBER, L_TRUE, L_FALSE, L_NULL
+    }
+    Literal;
+
+    inline bool isWord(const char* tok, size_t tok_size, const char* word)
+    {
+      return strlen(word) == tok_size && memcmp(tok, word, tok_size) == 0;
+    }
+
+    /* Whether c may follow a number or literal: whitespace, a
+       structural character, a comment or the end of the input */
+    inline bool endsLiteral(char c)
+    {
+      return !c || isSpace(c) || strchr("{}[]:,\"/", c);
+    }
+
+    /* Scan a number or a keyword. The value of a number is stored in num.
+       Every parser reads literals through here, so "01", "1x" and
+       "3true" are rejected the same way by all of them. */
+    inline Literal scanLiteral(char*& s, ParsedNumber& num)
+    {
+      char *tok_start;
+      char* tok_end;
+      int tok_size;
+      Literal literal = L_INVALID;
+
+      chomp(s);
+      tok_start = s;
+
+      // s starts with - or a digit
+      if(isDigit(*s) || *s == '-') {
+        if(parseNumber(s, num))
+          literal = L_NUMBER;
+      }
+      // alpha
+      else if(isalpha(*s)) {
+        do {
+          tok_end = s+1;
+          s++;
+        } while(isalnum(*s) || *s == '_');
+        tok_size = tok_end - tok_start;
+        if(isWord(tok_start, tok_size, "true"))
+          literal = L_TRUE;
+        else if(isWord(tok_start, tok_size, "false"))
+          literal = L_FALSE;
+        else if(isWord(tok_start, tok_size, "null"))
+          literal = L_NULL;
+      }
+
+      if(literal == L_INVALID)
+        fail(E_INVALID_LITERAL, tok_start);
+      else if(!endsLiteral(*s)) {
+        fail(E_UNEXPECTED_CHARACTER, s);
+        literal = L_INVALID;
+      }
+      return literal;
+    }
+
+    /* Report a literal found by scanLiteral to a handler */
+    template<typename _Handler>
+    bool sendLiteral(_Handler& handler, Literal literal, const ParsedNumber& num)
+    {
+      switch(literal)
+      {
+      case L_NUMBER:
+        if (num.kind == N_INT64)
+          return handler.int64((int64_t) num.bits);
+        else if (num.kind == N_UINT64)
+          return handler.uint64(num.bits);
+        return handler.number(num.d);
+      case L_TRUE:
+        return handler.boolean(true);
+      case L_FALSE:
+        return handler.boolean(false);
+      case L_NULL:
+        return handler.null();
+      default:
+        return false;
+      }
+    }
+
+    /* The JSON grammar, reported to a handler as a stream of events
+       (see Json::Handler) rather than built into a tree. Json::read
+       builds its Values from these events with a ValueBuilder. */
+    template<typename _Handler>
+    class Reader
+    {
+    public:
+      Reader(_Handler& h, size_t depth = DEFAULT_MAX_DEPTH) : handler(h), maxDepth(depth) {}
+
+      void setMaxDepth(size_t depth) { maxDepth = depth; }
+
+      /* Containers are tracked on an explicit stack rather than by
+         recursion, as in DocumentBuilder::parseGeneric */
+      bool parseGeneric(char*& s)
+      {
+        stack.clear();
+
+        while(1)
+        {
+          chomp(s);
+          if(*s == '{' || *s == '[') {
+            char kind = *s;
+            if(stack.size() >= maxDepth)
+              return fail(E_TOO_DEEP, s);
+            if(!(kind == '{' ? handler.startObject() : handler.startArray()))
+              return fail(E_HANDLER, s);
+            s++;
+            stack.push_back(kind);
+            chomp(s);
+            if(*s != closer(kind)) {
+              if(kind == '{' && !parseKey(s))
+                return false;
+              continue;
+            }
+            if(!close(s))
+              return false;
+          }
+          else if(*s == '\"') {
+            if(!parseString(s, false))
+              return false;
+          }
+          else if(!parseLiteral(s)) {
+            return false;
+          }
+
+          while(1)
+          {
+            if(stack.empty())
+              return true;
+
+            char kind = stack.back();
+            chomp(s);
+            if(*s == ',') {
+              s++;
+              chomp(s);
+              if(*s != closer(kind)) {
+                if(kind == '{' && !parseKey(s))
+                  return false;
+                break;
+              }
+            }
+            else if(*s != closer(kind))
+              return fail(E_EXPECTED_SEPARATOR, s);
+            if(!close(s))
+              return false;
+          }
+        }
+      }
+
+    private:
+      _Handler& handler;
+      size_t maxDepth;
+      std::vector<char> stack;
+      std::string scratch;
+
+      static char closer(char kind)
+      {
+        return kind == '{' ? '}' : ']';
+      }
+
+      /* End the innermost container at its closing bracket s */
+      bool close(char*& s)
+      {
+        char kind = stack.back();
+        stack.pop_back();
+        if(!(kind == '{' ? handler.endObject() : handler.endArray()))
+          return fail(E_HANDLER, s);
+        s++;
+        return true;
+      }
+
+      bool parseKey(char*& s)
+      {
+        if(!parseString(s, true))
+          return false;
+
+        chomp(s);
+        if(*s != ':')
+          return fail(E_EXPECTED_COLON, s);
+        s++;
+        return true;
+      }
+
+      /* Strings without escapes are passed straight from the input,
+         others are decoded into a scratch buffer first */
+      bool parseString(char*& s, bool key)
+      {
+        const char* begin;
+        size_t length;
+        bool escaped;
+        const char* at = s;
+
+        if(!scanCharString(s, begin, length, escaped))
+          return false;
+
+        if(escaped) {
+          scratch.resize(length);
+          if(!unescape(begin, begin + length, &scratch[0], length))
+            return false;
+          begin = scratch.data();
+        }
+
+        if(!(key ? handler.key(begin, length) : handler.string(begin, length)))
+          return fail(E_HANDLER, at);
+        return true;
+      }
+
+      bool parseLiteral(char*& s)
+      {
+        ParsedNumber num;
+        const char* at = s;
+        Literal literal = scanLiteral(s, num);
+        if(literal == L_INVALID)
+          return false;
+        if(!sendLiteral(handler, literal, num))
+          return fail(E_HANDLER, at);
+        return true;
+      }
+    };
+
+    /* Handler accepting every event, for a Reader that only checks
+       the grammar */
+    struct SyntaxCheck
+    {
+      bool null() { return true; }
+      bool boolean(bool) { return true; }
+      bool number(double) { return true; }
+      bool int64(int64_t) { return true; }
+      bool uint64(uint64_t) { return true; }
+      bool string(const char*, size_t) { return true; }
+      bool key(const char*, size_t) { return true; }
+      bool startObject() { return true; }
+      bool endObject() { return true; }
+      bool startArray() { return true; }
+      bool endArray() { return true; }
+    };
+
+    /* Handler building a tree of Values. Finished values wait on a
+       stack, together with the keys of the objects still open, until
+       their container ends. */
+    class ValueBuilder
+    {
+    public:
+      ~ValueBuilder()
+      {
+        for (size_t ii = 0 ; ii < values.size() ; ii++)
+          delete values[ii];
+      }
+
+      /* Take ownership of the value that was read */
+      Value* release()
+      {
+        Value* result = values.empty() ? NULL : values.back();
+        values.clear();
+        return result;
+      }
+
+      bool null() { return add(NULL); }
+      bool boolean(bool in) { return add(new Boolean(in)); }
+      bool number(double in) { return add(new Number(in)); }
+
+      bool int64(int64_t in)
+      {
+        Number* result = new Number((double) in);
+        result->kind = N_INT64;
+        result->i = in;
+        return add(result);
+      }
+
+      bool uint64(uint64_t in)
+      {
+        Number* result = new Number((double) in);
+        result->kind = N_UINT64;
+        result->u = in;
+        return add(result);
+      }
+
+      bool string(const char* in, size_t length) { return add(new String(std::string(in, length))); }
+
+      bool key(const char* in, size_t length)
+      {
+        keys.push_back(std::string(in, length));
+        return true;
+      }
+
+      bool startObject()
+      {
+        bases.push_back(values.size());
+        return true;
+      }
+
+      bool endObject()
+      {
+        size_t base = bases.back(), count = values.size() - base;
+        size_t first = keys.size() - count;
+        Object::MapType result;
+        for (size_t ii = 0 ; ii < count ; ii++)
+        {
+          Value*& field = result[keys[first + ii]];
+          delete field;
+          field = values[base + ii];
+        }
+        keys.resize(first);
+        return close(new Object(result));
+      }
+
+      bool startArray()
+      {
+        bases.push_back(values.size());
+        return true;
+      }
+
+      bool endArray()
+      {
+        size_t base = bases.back();
+        Array::VectorType result(values.begin() + base, values.end());
+        return close(new Array(result));
+      }
+
+    private:
+      std::vector<Value*> values;
+      std::vector<std::string> keys;
+      std::vector<size_t> bases;
+
+      bool add(Value* value)
+      {
+        values.push_back(value);
+        return true;
+      }
+
+      /* Replace the children of the innermost container with it */
+      bool close(Value* container)
+      {
+        values.resize(bases.back());
+        bases.pop_back();
+        return add(container);
+      }
+    };
+
+    inline Value* parseGeneric(char*& s)
+    {
+      ValueBuilder builder;
+      Reader<ValueBuilder> reader(builder);
+      if(!reader.parseGeneric(s))
+        return NULL;
+      return builder.release();
+    }
+
+    /* Character classes of a 64-byte block, one bit per byte */
+    struct BlockMasks
+    {
+      uint64_t quote;
+      uint64_t backslash;
+      uint64_t op;
+      uint64_t space;
+      uint64_t slash;
+    };
+
+    inline void classifyBlock(const char* in, BlockMasks& m)
+    {
+#if defined(JSONPARSER_AVX2)
+      uint64_t mask[5] = { 0, 0, 0, 0, 0 };
+      for (int ii = 0 ; ii < 64 ; ii += 32)
+      {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + ii));
+        __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+        __m256i ctrl = _mm256_sub_epi8(c, _mm256_set1_epi8(9));
+        __m256i op = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+                          _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+          _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(':')),
+                          _mm256_cmpeq_epi8(c, _mm256_set1_epi8(','))));
+        __m256i space = _mm256_or_si256(
+          _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+          _mm256_cmpeq_epi8(_mm256_min_epu8(ctrl, _mm256_set1_epi8(4)), ctrl));
+        mask[0] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('"'))) << ii;
+        mask[1] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\'))) << ii;
+        mask[2] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(op) << ii;
+        mask[3] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(space) << ii;
+        mask[4] |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'))) << ii;
+      }
+#elif defined(JSONPARSER_SSE2)
+      uint64_t mask[5] = { 0, 0, 0, 0, 0 };
+      for (int ii = 0 ; ii < 64 ; ii += 16)
+      {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + ii));
+        __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+        __m128i op = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                       _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+          _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(':')),
+                       _mm_cmpeq_epi8(c, _mm_set1_epi8(','))));
+        __m128i space = spaceMask(c);
+        mask[0] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('"'))) << ii;
+        mask[1] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))) << ii;
+        mask[2] |= (uint64_t) _mm_movemask_epi8(op) << ii;
+        mask[3] |= (uint64_t) _mm_movemask_epi8(space) << ii;
+        mask[4] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('/'))) << ii;
+      }
+#else
+      uint64_t mask[5] = { 0, 0, 0, 0, 0 };
+      for (int ii = 0 ; ii < 64 ; ii++)
+      {
+        unsigned char c = in[ii];
+        uint64_t bit = (uint64_t) 1 << ii;
+        if (c == '"') mask[0] |= bit;
+        else if (c == '\\') mask[1] |= bit;
+        else if ((c | 0x20) == '{' || (c | 0x20) == '}' || c == ':' || c == ',') mask[2] |= bit;
+        else if (isSpace(c)) mask[3] |= bit;
+        else if (c == '/') mask[4] |= bit;
+      }
+#endif
+      m.quote = mask[0];
+      m.backslash = mask[1];
+      m.op = mask[2];
+      m.space = mask[3];
+      m.slash = mask[4];
+    }
+
+    /* Running xor of every bit with the bits below it, which turns the
+       positions of quotes into a mask of the bytes between them */
+    inline uint64_t prefixXor(uint64_t bits)
+    {
+      bits ^= bits << 1;
+      bits ^= bits << 2;
+      bits ^= bits << 4;
+      bits ^= bits << 8;
+      bits ^= bits << 16;
+      bits ^= bits << 32;
+      return bits;
+    }
+
+    /* Stage one of parsing a Document: classify the input 64 bytes at a
+       time and record the offset of every structural character and
+       unescaped quote, and of the first byte of every literal outside of
+       strings. The builder then walks these offsets instead of the
+       bytes in between. Returns false if the input cannot be indexed
+       (comments, an unterminated string, or more than 4GB), in which
+       case it is parsed byte by byte instead. */
+    inline bool indexStructurals(const char* s, size_t length, std::vector<uint32_t>& out)
+    {
+      out.clear();
+      if (length >= 0xffffffffu)
+        return false;
+
+      uint64_t escapedCarry = 0;
+      uint64_t inStringCarry = 0;
+      uint64_t scalarCarry = 0;
+
+      for (size_t base = 0 ; base < length ; base += 64)
+      {
+        char tail[64];
+        const char* block = s + base;
+        if (length - base < 64)
+        {
+          memset(tail, ' ', sizeof(tail));
+          memcpy(tail, block, length - base);
+          block = tail;
+        }
+
+        BlockMasks m;
+        classifyBlock(block, m);
+
+        // Backslashes are rare enough to resolve one at a time: each one
+        // that is not itself escaped escapes the byte that follows it
+        uint64_t escaped = escapedCarry;
+        escapedCarry = 0;
+        for (uint64_t bs = m.backslash & ~escaped ; bs ; bs &= bs - 1)
+        {
+          int ii = trailingZeros(bs);
+          if (escaped & ((uint64_t) 1 << ii))
+            continue;
+          if (ii == 63)
+            escapedCarry = 1;
+          else
+            escaped |= (uint64_t) 1 << (ii + 1);
+        }
+
+        uint64_t quote = m.quote & ~escaped;
+        uint64_t inString = prefixXor(quote) ^ inStringCarry;
+        inStringCarry = (uint64_t) 0 - (inString >> 63);
+
+        if (m.slash & ~inString)
+          return false;
+
+        uint64_t scalar = ~(m.op | m.space | m.quote | inString);
+        uint64_t scalarStart = scalar & ~((scalar << 1) | scalarCarry);
+        scalarCarry = scalar >> 63;
+
+        uint64_t bits = (m.op & ~inString) | quote | scalarStart;
+        while (bits)
+        {
+          out.push_back((uint32_t) (base + trailingZeros(bits)));
+          bits &= bits - 1;
+        }
+      }
+
+      return inStringCarry == 0;
+    }
+
+    /* Step over a quoted string, s pointing at its opening quote */
+    inline bool skipString(char*& s)
+    {
+      s++;
+      while(1) {
+        s = findQuoteOrEscape(s);
+        if(*s == '"')
+          break;
+        if(*s == 0 || *(s + 1) == 0)
+          return false;
+        s += 2;
+      }
+      s++;
+      return true;
+    }
+
+    /* Step over the container starting at s by matching brackets,
+       one character at a time */
+    inline bool skipBrackets(char*& s)
+    {
+      size_t depth = 0;
+      while(1) {
+        s += strcspn(s, "\"[]{}/");
+        switch(*s) {
+        case '"':
+          if(!skipString(s))
+            return false;
+          break;
+        case '[':
+        case '{':
+          depth++;
+          s++;
+          break;
+        case ']':
+        case '}':
+          s++;
+          if(--depth == 0)
+            return true;
+          break;
+        case '/':
+          s = *(s + 1) == '/' ? skipLine(s + 2) : s + 1;
+          break;
+        default:
+          return false;
+        }
+      }
+    }
+
+    /* Finds the brackets and commas outside of strings in JSON text 64
+       bytes at a time, masking strings out as indexStructurals does.
+       Blocks are read from 64-byte aligned addresses, which cannot
+       cross a page, up to the one holding the terminating NUL. */
+    class BracketScanner
+    {
+    public:
+      /* Bits of the current block outside of strings, from s onwards */
+      uint64_t open;
+      uint64_t close;
+      uint64_t comma;
+      uint64_t slash;
+      bool end;
+
+      BracketScanner(const char* s)
+        : block((const char*) ((uintptr_t) s & ~(uintptr_t) 63)),
+          from(~(uint64_t) 0 << (s - block)), escapedCarry(0), inStringCarry(0) {}
+
+      /* Classify the current block and move on to the next one */
+      JSONPARSER_NO_SANITIZE void scan()
+      {
+        uint64_t mask[7] = { 0, 0, 0, 0, 0, 0, 0 };
+#if defined(JSONPARSER_SSE2)
+        for (int ii = 0 ; ii < 64 ; ii += 16)
+        {
+          __m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(block + ii));
+          __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+          mask[0] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('"'))) << ii;
+          mask[1] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))) << ii;
+          mask[2] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{'))) << ii;
+          mask[3] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))) << ii;
+          mask[4] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(','))) << ii;
+          mask[5] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('/'))) << ii;
+          mask[6] |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_setzero_si128())) << ii;
+        }
+#else
+        // Without SIMD, stop reading at the NUL
+        for (int ii = trailingZeros(from) ; ii < 64 ; ii++)
+        {
+          unsigned char c = block[ii];
+          uint64_t bit = (uint64_t) 1 << ii;
+          if (c == '"') mask[0] |= bit;
+          else if (c == '\\') mask[1] |= bit;
+          else if ((c | 0x20) == '{') mask[2] |= bit;
+          else if ((c | 0x20) == '}') mask[3] |= bit;
+          else if (c == ',') mask[4] |= bit;
+          else if (c == '/') mask[5] |= bit;
+          else if (c == 0) { mask[6] |= bit; break; }
+        }
+#endif
+
+        uint64_t escaped = escapedCarry;
+        escapedCarry = 0;
+        for (uint64_t bs = mask[1] & from & ~escaped ; bs ; bs &= bs - 1)
+        {
+          int ii = trailingZeros(bs);
+          if (escaped & ((uint64_t) 1 << ii))
+            continue;
+          if (ii == 63)
+            escapedCarry = 1;
+          else
+            escaped |= (uint64_t) 1 << (ii + 1);
+        }
+
+        uint64_t inString = prefixXor(mask[0] & from & ~escaped) ^ inStringCarry;
+        inStringCarry = (uint64_t) 0 - (inString >> 63);
+
+        uint64_t nul = mask[6] & from;
+        uint64_t live = from & ~inString & (nul ? (nul & (0 - nul)) - 1 : ~(uint64_t) 0);
+        open = mask[2] & live;
+        close = mask[3] & live;
+        comma = mask[4] & live;
+        slash = mask[5] & live;
+        end = nul != 0;
+
+        current = block;
+        block += 64;
+        from = ~(uint64_t) 0;
+      }
+
+      /* Address of a bit of the block last scanned */
+      const char* position(int bit) const { return current + bit; }
+
+    private:
+      const char* block;
+      const char* current;
+      uint64_t from;
+      uint64_t escapedCarry;
+      uint64_t inStringCarry;
+    };
+
+    /* Step over the container starting at s with a BracketScanner,
+       counting brackets. Containers with comments are left to
+       skipBrackets. */
+    inline bool skipContainer(char*& s)
+    {
+      BracketScanner scanner(s);
+      size_t depth = 0;
+
+      do
+      {
+        scanner.scan();
+        if (scanner.slash)
+          return skipBrackets(s);
+
+        for (uint64_t bits = scanner.open | scanner.close ; bits ; bits &= bits - 1)
+        {
+          int ii = trailingZeros(bits);
+          depth += ((scanner.open >> ii) & 1) ? 1 : (size_t) -1;
+          if (depth == 0)
+          {
+            s = (char*) scanner.position(ii + 1);
+            return true;
+          }
+        }
+      }
+      while (!scanner.end);
+      return false;
+    }
+
+    /* Step over one value without decoding it: a string up to its
+       closing quote, a container by matching brackets, anything else up
+       to the next delimiter. The contents of a skipped container are not
+       checked beyond the nesting of its brackets. */
+    inline bool skipValue(char*& s)
+    {
+      chomp(s);
+      char* begin = s;
+      if(*s == '"')
+        return skipString(s) || fail(E_UNTERMINATED_STRING, begin);
+
+      if(*s != '{' && *s != '[') {
+        while(*s && !isSpace(*s) && !strchr(",:]}/", *s))
+          s++;
+        return s != begin || fail(E_UNEXPECTED_CHARACTER, s);
+      }
+
+      return skipContainer(s) || fail(E_UNBALANCED, begin);
+    }
+
+    /* Find where to cut the array starting at s into about parts pieces
+       of whole elements: the first comma between elements at or after
+       each of the offsets length / parts * n. The closing bracket is
+       appended last. Returns false for arrays with comments or that are
+       unterminated. */
+    inline bool findArrayCuts(const char* s, size_t length, size_t parts, std::vector<const char*>& cuts)
+    {
+      BracketScanner scanner(s);
+      size_t depth = 0;
+      const char* target = parts > 1 ? s + length / parts : NULL;
+
+      cuts.clear();
+      do
+      {
+        scanner.scan();
+        if (scanner.slash)
+          return false;
+
+        uint64_t open = scanner.open;
+        uint64_t bits = open | scanner.close;
+        if (depth == 1 && !bits && target && scanner.position(63) < target)
+          continue;
+
+        for (bits |= scanner.comma ; bits ; bits &= bits - 1)
+        {
+          int ii = trailingZeros(bits);
+          uint64_t bit = (uint64_t) 1 << ii;
+          if (scanner.comma & bit)
+          {
+            if (depth == 1 && target && scanner.position(ii) >= target)
+            {
+              cuts.push_back(scanner.position(ii));
+              target = cuts.size() + 1 < parts ? s + length / parts * (cuts.size() + 1) : NULL;
+            }
+          }
+          else if (open & bit)
+            depth++;
+          else if (--depth == 0)
+          {
+            cuts.push_back(scanner.position(ii));
+            return true;
+          }
+        }
+      }
+      while (!scanner.end);
+      return false;
+    }
+
+    /* Builds the dom tree of a Document. Children are collected on
+       scratch stacks shared by every nesting level and copied into the
+       Arena in one piece once their container closes. */
+    class DocumentBuilder
+    {
+    public:
+      DocumentBuilder(Arena& a, int f = P_DEFAULT, KeyTable* k = NULL, size_t depth = DEFAULT_MAX_DEPTH)
+        : arena(a), flags(f), keys(k), maxDepth(depth), checker(check), checked(false) {}
+
+      /* Change the options of the next parse. The scratch stacks keep
+         their capacity, so a builder used over and over stops
+         allocating once it has seen its largest input. With P_LAZY,
+         containers nested in the value being parsed are checked
+         without being built and left for materialize(). */
+      void configure(int f, KeyTable* k, size_t depth)
+      {
+        flags = f;
+        keys = k;
+        maxDepth = depth;
+        checked = false;
+      }
+
+      /* Parse the text of a lazy container, which was checked when it
+         was stepped over, so the containers inside it are not checked
+         again */
+      bool parseChecked(char*& s, dom::Node& out)
+      {
+        checked = true;
+        bool ok = parseGeneric(s, out);
+        checked = false;
+        return ok;
+      }
+
+      /* Containers are parsed in a loop rather than by recursion: each
+         open one has a Frame on a stack, and a value that completes is
+         added to the innermost one, which may complete in turn */
+      bool parseGeneric(char*& s, dom::Node& out)
+      {
+        dom::Node value;
+        frames.clear();
+
+        while(1)
+        {
+          chomp(s);
+          if((*s == '{' || *s == '[') && (flags & P_LAZY) && !frames.empty()) {
+            if(!skipLazy(s, value))
+              return false;
+          }
+          else if(*s == '{' || *s == '[') {
+            char kind = *s;
+            if(!open(s))
+              return false;
+            s++;
+            chomp(s);
+            if(*s != closer(kind)) {
+              if(kind == '{' && !parseKey(s))
+                return false;
+              continue;
+            }
+            if(!close(s, value))
+              return false;
+            s++;
+          }
+          else if(*s == '\"') {
+            if(!parseString(s, value))
+              return false;
+          }
+          else if(!parseLiteral(s, value)) {
+            return false;
+          }
+
+          while(1)
+          {
+            if(frames.empty()) {
+              out = value;
+              return true;
+            }
+            add(value);
+
+            char kind = frames.back().kind;
+            chomp(s);
+            if(*s == ',') {
+              s++;
+              chomp(s);
+              if(*s != closer(kind)) {
+                if(kind == '{' && !parseKey(s))
+                  return false;
+                break;
+              }
+            }
+            else if(*s != closer(kind))
+              return fail(E_EXPECTED_SEPARATOR, s);
+            if(!close(s, value))
+              return false;
+            s++;
+          }
+        }
+      }
+
+      /* Build the tree by walking the offsets found by indexStructurals */
+      bool parseIndexed(char* s, const std::vector<uint32_t>& index, dom::Node& out)
+      {
+        input = s;
+        structurals = index.empty() ? NULL : &index[0];
+        remaining = index.size();
+        return walkGeneric(out);
+      }
+
+    private:
+      /* An open container: the kind of its opening bracket, and where
+         its children start on the scratch stacks */
+      struct Frame
+      {
+        char kind;
+        size_t base;
+        Frame(char k, size_t b) : kind(k), base(b) {}
+      };
+
+      Arena& arena;
+      int flags;
+      KeyTable* keys;
+      size_t maxDepth;
+      std::string scratch;
+      std::vector<Frame> frames;
+      std::vector<dom::Node> items;
+      std::vector<dom::Member> members;
+      std::vector<uint32_t> order;  // positions of the members kept by P_SORTED_KEYS
+
+      SyntaxCheck check;
+      Reader<SyntaxCheck> checker;  // reads the containers P_LAZY steps over
+      bool checked;                 // set while materializing one
+
+      char* input;
+      const uint32_t* structurals;
+      size_t remaining;
+
+      static char closer(char kind)
+      {
+        return kind == '{' ? '}' : ']';
+      }
+
+      /* Open a container at its opening bracket s */
+      bool open(const char* s)
+      {
+        char kind = *s;
+        if(frames.size() >= maxDepth)
+          return fail(E_TOO_DEEP, s);
+        frames.push_back(Frame(kind, kind == '{' ? members.size() : items.size()));
+        return true;
+      }
+
+      /* Add a completed value to the innermost container. An object
+         member was pushed when its key was read. */
+      void add(const dom::Node& value)
+      {
+        if(frames.back().kind == '{')
+          members.back().value = value;
+        else
+          items.push_back(value);
+      }
+
+      /* Finish the innermost container at its closing bracket */
+      bool close(const char* at, dom::Node& out)
+      {
+        Frame frame = frames.back();
+        frames.pop_back();
+        size_t count = (frame.kind == '{' ? members.size() : items.size()) - frame.base;
+        if(!fits(count, at))
+          return false;
+        if(frame.kind == '{')
+          out = commitObject(frame.base);
+        else
+          out = dom::Node::makeArray(commit(items, frame.base), count);
+        return true;
+      }
+
+      /* Node lengths are 32 bits wide; longer strings and containers
+         are rejected rather than truncated */
+      static bool fits(size_t length, const char* at)
+      {
+        return length <= dom::Node::MAX_LENGTH || fail(E_TOO_LARGE, at);
+      }
+
+      /* Step over a container and record where its text lies. Its
+         grammar is checked as it would be if it were built, within what
+         is left of the depth limit, so that malformed input fails the
+         parse rather than the first read of the container. */
+      bool skipLazy(char*& s, dom::Node& out)
+      {
+        char* begin = s;
+        if(checked) {
+          if(!skipContainer(s))
+            return fail(E_UNBALANCED, begin);
+        }
+        else {
+          checker.setMaxDepth(maxDepth - frames.size());
+          if(!checker.parseGeneric(s))
+            return false;
+        }
+        LazyRange* range = arena.allocate<LazyRange>(1);
+        range->begin = begin;
+        range->end = s;
+        range->builder = this;
+        out = dom::Node::makeLazy(*begin == '{' ? T_OBJECT : T_ARRAY, range);
+        return true;
+      }
+
+      char* peek() const
+      {
+        return remaining ? input + *structurals : input + strlen(input);
+      }
+
+      char* advance()
+      {
+        char* p = peek();
+        if (remaining)
+        {
+          structurals++;
+          remaining--;
+        }
+        return p;
+      }
+
+      /* The same loop as parseGeneric over the structural index */
+      bool walkGeneric(dom::Node& out)
+      {
+        dom::Node value;
+        frames.clear();
+
+        while(1)
+        {
+          char* p = advance();
+          if(*p == '{') {
+            if(!open(p))
+              return false;
+            p = advance();
+            if(*p != '}') {
+              if(!walkKey(p))
+                return false;
+              continue;
+            }
+            if(!close(p, value))
+              return false;
+          }
+          else if(*p == '[') {
+            if(!open(p))
+              return false;
+            if(*peek() != ']')
+              continue;
+            if(!close(advance(), value))
+              return false;
+          }
+          else if(*p == '\"') {
+            if(!walkString(p, value))
+              return false;
+          }
+          else if(!parseLiteral(p, value)) {
+            return false;
+          }
+
+          while(1)
+          {
+            if(frames.empty()) {
+              out = value;
+              return true;
+            }
+            add(value);
+
+            char kind = frames.back().kind;
+            p = advance();
+            if(*p == ',') {
+              if(kind == '{') {
+                p = advance();
+                if(*p != '}') {
+                  if(!walkKey(p))
+                    return false;
+                  break;
+                }
+              }
+              else if(*peek() != ']')
+                break;
+              else
+                p = advance();
+            }
+            else if(*p != closer(kind))
+              return fail(E_EXPECTED_SEPARATOR, p);
+            if(!close(p, value))
+              return false;
+          }
+        }
+      }
+
+      bool walkString(char* open, dom::Node& out, bool key = false)
+      {
+        char* close = advance();
+        size_t length = close - open - 1;
+        bool escaped = memchr(open + 1, '\\', length) != NULL;
+        return key ? makeKey(open + 1, length, escaped, out)
+          : makeString(open + 1, length, escaped, out);
+      }
+
+      /* Start an object member at the key at p, up to its ':' */
+      bool walkKey(char* p)
+      {
+        if(*p != '"')
+          return fail(E_EXPECTED_KEY, p);
+        members.push_back(dom::Member());
+        if(!walkString(p, members.back().key, true))
+          return false;
+
+        p = advance();
+        if(*p != ':')
+          return fail(E_EXPECTED_COLON, p);
+        return true;
+      }
+
+      template<typename _T>
+      const _T* commit(std::vector<_T>& stack, size_t base)
+      {
+        size_t count = stack.size() - base;
+        _T* v = arena.allocate<_T>(count);
+        if (count)
+          memcpy(v, &stack[base], count * sizeof(_T));
+        stack.resize(base);
+        return v;
+      }
+
+      /* Orders the positions of an object's members by key, and members
+         with equal keys by position, so that std::sort is stable without
+         the buffer std::stable_sort would allocate */
+      struct MemberOrder
+      {
+        const dom::Member* m;
+        MemberOrder(const dom::Member* in) : m(in) {}
+
+        bool operator()(uint32_t a, uint32_t b) const
+        {
+          StringRef x = m[a].key.string(), y = m[b].key.string();
+          int c = memcmp(x.data(), y.data(), x.size() < y.size() ? x.size() : y.size());
+          return c < 0 || (c == 0 && (x.size() < y.size() || (x.size() == y.size() && a < b)));
+        }
+      };
+
+      /* Move the members of an object from the scratch stack into the
+         arena, sorting them with P_SORTED_KEYS and appending a hash
+         index to large objects. Sorting works on the order stack, which
+         is kept from one object and one parse to the next. */
+      dom::Node commitObject(size_t base)
+      {
+        order.clear();
+        if((flags & P_SORTED_KEYS) && members.size() > base) {
+          const dom::Member* m = &members[base];
+          for(uint32_t ii = 0 ; ii < members.size() - base ; ii++)
+            order.push_back(ii);
+          std::sort(order.begin(), order.end(), MemberOrder(m));
+          size_t kept = 0;
+          for(size_t ii = 0 ; ii < order.size() ; ii++) {
+            if(ii + 1 < order.size() && m[order[ii]].key.string() == m[order[ii + 1]].key.string())
+              continue;
+            order[kept++] = order[ii];
+          }
+          order.resize(kept);
+        }
+
+        size_t count = order.empty() ? members.size() - base : order.size();
+        bool indexed = count > dom::Object::HASH_THRESHOLD;
+        for(size_t ii = base ; indexed && ii < members.size() ; ii++)
+          indexed = !members[ii].key.string().escaped();
+
+        size_t capacity = indexed ? hashCapacity(count) : 0;
+        dom::Member* v = static_cast<dom::Member*>(
+          arena.allocate(count * sizeof(dom::Member) + capacity * sizeof(uint32_t)));
+        if(!order.empty()) {
+          for(size_t ii = 0 ; ii < count ; ii++)
+            v[ii] = members[base + order[ii]];
+        }
+        else if(count)
+          memcpy(v, &members[base], count * sizeof(dom::Member));
+        members.resize(base);
+
+        if(indexed) {
+          uint32_t* index = reinterpret_cast<uint32_t*>(v + count);
+          memset(index, 0xff, capacity * sizeof(uint32_t));
+          for(size_t ii = 0 ; ii < count ; ii++) {
+            StringRef key = v[ii].key.string();
+            size_t slot = hashKey(key.data(), key.size()) & (capacity - 1);
+            while(index[slot] != dom::Object::EMPTY && v[index[slot]].key.string() != key)
+              slot = (slot + 1) & (capacity - 1);
+            index[slot] = (uint32_t) ii;
+          }
+        }
+
+        return dom::Node::makeObject(v, count, indexed);
+      }
+
+      /* Start an object member at the key at s, up to its ':' */
+      bool parseKey(char*& s)
+      {
+        members.push_back(dom::Member());
+        if(!parseString(s, members.back().key, true))
+          return false;
+
+        chomp(s);
+        if(*s != ':')
+          return fail(E_EXPECTED_COLON, s);
+        s++;
+        return true;
+      }
+
+      bool parseString(char*& s, dom::Node& out, bool key = false)
+      {
+        const char* begin;
+        size_t length;
+        bool escaped;
+
+        if(!scanCharString(s, begin, length, escaped))
+          return false;
+
+        return key ? makeKey(begin, length, escaped, out)
+          : makeString(begin, length, escaped, out);
+      }
+
+      /* Object keys are interned when a KeyTable is attached, and
+         stored like any other string otherwise or if it is full. With
+         P_SORTED_KEYS members are sorted and matched by their bytes, so
+         escaped keys are decoded even with P_ZERO_COPY. */
+      bool makeKey(const char* begin, size_t length, bool escaped, dom::Node& out)
+      {
+        if(!fits(length, begin))
+          return false;
+        bool decode = escaped && (flags & P_SORTED_KEYS);
+        if(!keys)
+          return makeString(begin, length, escaped, out, decode);
+
+        InternedKey key;
+        if(escaped) {
+          size_t decoded;
+          scratch.resize(length);
+          if(!unescape(begin, begin + length, &scratch[0], decoded))
+            return false;
+          key = keys->intern(scratch.data(), decoded);
+        }
+        else
+          key = keys->intern(begin, length);
+
+        if(!key.data())
+          return makeString(begin, length, escaped, out, decode);
+        out = dom::Node::makeKey(key);
+        return true;
+      }
+
+      /* Copy raw string contents into the arena, decoding escapes, or
+         with P_ZERO_COPY refer to them where they are unless copy is
+         set. With P_INSITU they are decoded and NUL-terminated where
+         they are. */
+      bool makeString(const char* begin, size_t length, bool escaped, dom::Node& out, bool copy = false)
+      {
+        if(!fits(length, begin))
+          return false;
+        if(flags & P_INSITU) {
+          char* v = const_cast<char*>(begin);
+          if(escaped && !unescape(begin, begin + length, v, length))
+            return false;
+          v[length] = '\0';
+          out = dom::Node::makeString(v, length);
+          return true;
+        }
+
+        if((flags & P_ZERO_COPY) && !copy) {
+          if(escaped && !validEscapes(begin, begin + length))
+            return false;
+          out = dom::Node::makeString(begin, length, escaped);
+          return true;
+        }
+
+        if(!escaped) {
+          out = dom::Node::makeString(arena.copy(begin, length), length);
+          return true;
+        }
+
+        char* v = static_cast<char*>(arena.allocate(length + 1, 1));
+        if(!unescape(begin, begin + length, v, length))
+          return false;
+        v[length] = '\0';
+        out = dom::Node::makeString(v, length);
+        return true;
+      }
+
+      bool parseLiteral(char*& s, dom::Node& out)
+      {
+        ParsedNumber num;
+
+        switch(scanLiteral(s, num))
+        {
+        case L_NUMBER:
+          if (num.kind == N_INT64)
+            out = dom::Node::makeInt64((int64_t) num.bits);
+          else if (num.kind == N_UINT64)
+            out = dom::Node::makeUInt64(num.bits);
+          else
+            out = dom::Node::makeNumber(num.d);
+          return true;
+        case L_TRUE:
+          out = dom::Node::makeBoolean(true);
+          return true;
+        case L_FALSE:
+          out = dom::Node::makeBoolean(false);
+          return true;
+        case L_NULL:
+          out = dom::Node::makeNull();
+          return true;
+        default:
+          return false;
+        }
+      }
+    };
+
+    /* Parse the container a lazy node stands for, one level deep, and
+       put it in the node's place. Its text was checked when the
+       Document was parsed; should it fail anyway the node becomes null. */
+    inline bool materialize(dom::Node& node)
+    {
+      const LazyRange* range = node.payload.range;
+      char* s = range->begin;
+      dom::Node value;
+      bool ok = range->builder->parseChecked(s, value) && s == range->end;
+      node = ok ? value : dom::Node::makeNull();
+      return ok;
+    }
+
+#if defined(JSONPARSER_CXX11)
+    /* A piece of a top-level array, built on a thread of its own */
+    class ArrayPart
+    {
+    public:
+      Arena arena;
+      std::vector<dom::Node> items;
+      bool ok;
+      Failure error;   // recorded on the piece's own thread
+
+      std::exception_ptr thrown;  // such as std::bad_alloc, rethrown by the calling thread
+
+      ArrayPart() : ok(false) {}
+
+      void parse(char* s, const char* end, int flags, KeyTable* keys, size_t maxDepth)
+      {
+        try {
+          ok = parseItems(s, end, flags, keys, maxDepth);
+        }
+        catch (...) {
+          ok = false;
+          thrown = std::current_exception();
+          return;
+        }
+        if (!ok)
+          error = failure();
+      }
+
+    private:
+      /* Parse the elements between s and end, the comma or bracket
+         following the last of them. As in parseList, only the last
+         piece may be empty, and a comma may directly precede the
+         closing bracket. */
+      bool parseItems(char* s, const char* end, int flags, KeyTable* keys, size_t maxDepth)
+      {
+        DocumentBuilder builder(arena, flags, keys, maxDepth);
+
+        chomp(s);
+        if(s == end && *end == ']')
+          return true;
+
+        while(1)
+        {
+          dom::Node value;
+          if(!builder.parseGeneric(s, value))
+            return false;
+          items.push_back(value);
+
+          chomp(s);
+          if(s == end)
+            return true;
+          if(s > end || *s != ',')
+            return fail(E_EXPECTED_SEPARATOR, s);
+          s++;
+          chomp(s);
+          if(s == end && *end == ']')
+            return true;
+        }
+      }
+    };
+
+    /* Inputs smaller than this are not worth parsing in parallel */
+    static const size_t PARALLEL_MIN = 1 << 20;
+
+    /* Parse the array opening at s in the pieces ending at each of cuts
+       (see findArrayCuts), one thread per piece. The elements are then
+       copied into a single array in arena, which takes over the Arena
+       of every piece. An exception thrown while parsing a piece is
+       rethrown here once every thread has finished, as the serial
+       parser would have thrown it; a piece whose thread cannot be
+       started is parsed on this one. */
+    inline bool parseArrayParts(char* s, const std::vector<const char*>& cuts, Arena& arena,
+                                int flags, KeyTable* keys, size_t maxDepth, dom::Node& out)
+    {
+      std::vector<std::unique_ptr<ArrayPart> > parts;
+      std::vector<std::thread> threads;
+      for (size_t ii = 0 ; ii < cuts.size() ; ii++)
+        parts.push_back(std::unique_ptr<ArrayPart>(new ArrayPart()));
+      threads.reserve(cuts.size());
+
+      // nothing below may throw while a thread is running
+      char* begin = s + 1;
+      for (size_t ii = 0 ; ii < cuts.size() ; ii++)
+      {
+        bool started = false;
+        if (ii + 1 < cuts.size())
+        {
+          try {
+            threads.push_back(std::thread(&ArrayPart::parse, parts[ii].get(), begin, cuts[ii], flags, keys, maxDepth - 1));
+            started = true;
+          }
+          catch (const std::system_error&) {
+          }
+        }
+        if (!started)
+          parts[ii]->parse(begin, cuts[ii], flags, keys, maxDepth - 1);
+        begin = (char*) cuts[ii] + 1;
+      }
+      for (size_t ii = 0 ; ii < threads.size() ; ii++)
+        threads[ii].join();
+
+      for (size_t ii = 0 ; ii < parts.size() ; ii++)
+      {
+        if (parts[ii]->thrown)
+          std::rethrow_exception(parts[ii]->thrown);
+      }
+
+      size_t count = 0;
+      for (size_t ii = 0 ; ii < parts.size() ; ii++)
+      {
+        if (!parts[ii]->ok)
+        {
+          failure().code = parts[ii]->error.code;
+          failure().at = parts[ii]->error.at;
+          return false;
+        }
+        count += parts[ii]->items.size();
+      }
+      if (count > dom::Node::MAX_LENGTH)
+        return fail(E_TOO_LARGE, s);
+
+      dom::Node* v = arena.allocate<dom::Node>(count);
+      dom::Node* next = v;
+      for (size_t ii = 0 ; ii < parts.size() ; ii++)
+      {
+        std::vector<dom::Node>& items = parts[ii]->items;
+        if (!items.empty())
+          memcpy(next, &items[0], items.size() * sizeof(dom::Node));
+        next += items.size();
+        arena.splice(parts[ii]->arena);
+      }
+      out = dom::Node::makeArray(v, count);
+      return true;
+    }
+#endif
+
+    void formatGeneric(const Value* obj, std::stringstream& out);
+
+    inline void formatNumber(const Number* num, std::stringstream& out)
+    {
+      if (num->getKind() == N_INT64)
+        out << num->i;
+      else if (num->getKind() == N_UINT64)
+        out << num->u;
+      else
+        out << num->value();
+    }
+
+    inline std::string escape(std::string const &s)
+    {
+      std::size_t n = s.length();
+      std::string escaped;
+      escaped.reserve(n * 2);        // pessimistic preallocation
+
+      for (std::size_t ii = 0; ii < n; ++ii) {
+        switch (s[ii]) {
+        case '\\': escaped += "\\\\"; break;
+        case '\"': escaped += "\\\""; break;
+        case '\b': escaped += "\\b"; break;
+        case '\f': escaped += "\\f"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        case '\t': escaped += "\\t"; break;
+        default:
+          if ((unsigned char) s[ii] < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            escaped += "\\u00";
+            escaped += hex[(unsigned char) s[ii] >> 4];
+            escaped += hex[s[ii] & 0xf];
+          }
+          else
+            escaped += s[ii];
+        }
+      }
+      return escaped;
+    }
+
+    inline void formatString(const std::string& str, std::stringstream& out) 
+    {
+      out << "\"" << escape(str) << "\"";
+    }
+
+    inline void formatString(const String* str, std::stringstream& out)
+    {
+      formatString(str->value(), out);
+    }
+
+    inline void formatBoolean(const Boolean* bo, std::stringstream& out)
+    {
+      out << (bo->value() ? "true" : "false");
+    }
+
+    inline void formatArray(const Array* arr, std::stringstream& out)
+    {
+      out << "[";
+
+      for(size_t ii = 0 ; ii < arr->size() ; ++ii)
+      {
+        if(ii > 0) out << ", ";
+        const Value* entry = arr->get(ii);
+        formatGeneric(entry, out);
+      }
+
+      out << "]";
+    }
+
+    inline void formatObject(const Object* obj, std::stringstream& out)
+    {
+      out << "{";
+
+      Object::KeySet keys = obj->keys();
+      bool first = true;
+      for(Object::KeySet::iterator it = keys.begin() ; it != keys.end() ; it++)
+      {
+        if (!first) out << ", ";
+        const std::string& key = *it;
+        formatString(key, out);
+        out << " : ";
+        const Value* entry = obj->get(key);
+        formatGeneric(entry, out);
+        first = false;
+      }
+
+      out << "}";
+    }
+
+    inline void formatGeneric(const Value* obj, std::stringstream& out)
+    {
+      if (!obj)
+      {
+        out << "null";
+        return;
+      }
+
+      switch(obj->getType())
+      {
+      case T_NUMBER:
+        formatNumber(static_cast<const Number*>(obj), out);
+        break;
+      case T_STRING:
+        formatString(static_cast<const String*>(obj), out);
+        break;
+      case T_BOOLEAN:
+        formatBoolean(static_cast<const Boolean*>(obj), out);
+        break;
+      case T_ARRAY:
+        formatArray(static_cast<const Array*>(obj), out);
+        break;
+      case T_OBJECT:
+        formatObject(static_cast<const Object*>(obj), out);
+        break;
+      default:
+        out << "???";
+      }
+    }
+
+    inline void formatGeneric(const dom::Node& node, std::stringstream& out)
+    {
+      switch(node.getType())
+      {
+      case T_NUMBER:
+        if (node.numberKind() == N_INT64)
+          out << node.int64();
+        else if (node.numberKind() == N_UINT64)
+          out << node.uint64();
+        else
+          out << node.number();
+        break;
+      case T_STRING:
+        formatString(node.string().str(), out);
+        break;
+      case T_BOOLEAN:
+        out << (node.boolean() ? "true" : "false");
+        break;
+      case T_ARRAY:
+        {
+          dom::Array arr(node);
+          out << "[";
+          for(size_t ii = 0 ; ii < arr.size() ; ++ii)
+          {
+            if(ii > 0) out << ", ";
+            formatGeneric(arr[ii], out);
+          }
+          out << "]";
+        }
+        break;
+      case T_OBJECT:
+        {
+          dom::Object obj(node);
+          out << "{";
+          for(size_t ii = 0 ; ii < obj.size() ; ++ii)
+          {
+            if(ii > 0) out << ", ";
+            const dom::Member& member = obj.member(ii);
+            formatString(member.key.string().str(), out);
+            out << " : ";
+            formatGeneric(member.value, out);
+          }
+          out << "}";
+        }
+        break;
+      default:
+        out << "null";
+      }
+    }
+
+
+  }; // namespace
+
+
+
+  /* Base for handlers passed to Json::parse, accepting every event.
+     Derive from Handler<YourHandler> and hide the events of interest;
+     each returns false to stop parsing. Integers that fit an int64_t or
+     uint64_t are reported through int64() and uint64(), which forward
+     to number() unless hidden. Strings and keys are decoded and only
+     valid during the call. */
+  template<typename _Derived>
+  struct Handler
+  {
+    bool null() { return true; }
+    bool boolean(bool) { return true; }
+    bool number(double) { return true; }
+    bool int64(int64_t in) { return static_cast<_Derived*>(this)->number((double) in); }
+    bool uint64(uint64_t in) { return static_cast<_Derived*>(this)->number((double) in); }
+    bool string(const char*, size_t) { return true; }
+    bool key(const char*, size_t) { return true; }
+    bool startObject() { return true; }
+    bool endObject() { return true; }
+    bool startArray() { return true; }
+    bool endArray() { return true; }
+  };
+
+  /* Parse a string of characters without building a tree, calling
+     handler for each value, key and container boundary in document
+     order. Returns false if the input is malformed, nests containers
+     more than maxDepth deep, or the handler stopped the parse; see
+     lastError() for which. */
+  template<typename _Handler>
+  bool parse(const char* s, _Handler& handler, size_t maxDepth = DEFAULT_MAX_DEPTH)
+  {
+    impl::begin(s);
+    char* p = (char*) s;
+    impl::Reader<_Handler> reader(handler, maxDepth);
+    return reader.parseGeneric(p);
+  }
+
+  namespace impl {
+
+    /* Find the first byte in [s, end) that a string cannot hold as it
+       is: '"', '\\', a control character or the first byte of a
+       multi-byte UTF-8 sequence. Returns end if there is none. Unlike
+       the other scanners it never reads past end, so the text need not
+       be NUL-terminated. */
+    inline const char* findStringSpecial(const char* s, const char* end)
+    {
+#if defined(JSONPARSER_SSE2)
+      while (end - s >= 16)
+      {
+        __m128i c = _mm_loadu_si128((const __m128i*) s);
+        unsigned int stop = _mm_movemask_epi8(_mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('"')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))),
+          _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(0x1f)), c))) | _mm_movemask_epi8(c);
+        if (stop)
+          return s + trailingZeros(stop);
+        s += 16;
+      }
+#endif
+      while (s < end && (unsigned char) (*s - 0x20) < 0x60 && *s != '"' && *s != '\\')
+        ++s;
+      return s;
+    }
+
+    /* Step over the UTF-8 sequence starting at s, which must be well
+       formed and end before end: no overlong forms, surrogates or code
+       points past U+10FFFF */
+    inline bool skipUtf8(const char*& s, const char* end)
+    {
+      const unsigned char* u = (const unsigned char*) s;
+      unsigned char lo = 0x80, hi = 0xbf;
+      int more;
+      if (u[0] >= 0xc2 && u[0] <= 0xdf)
+        more = 1;
+      else if (u[0] >= 0xe0 && u[0] <= 0xef)
+      {
+        more = 2;
+        if (u[0] == 0xe0) lo = 0xa0;
+        if (u[0] == 0xed) hi = 0x9f;
+      }
+      else if (u[0] >= 0xf0 && u[0] <= 0xf4)
+      {
+        more = 3;
+        if (u[0] == 0xf0) lo = 0x90;
+        if (u[0] == 0xf4) hi = 0x8f;
+      }
+      else
+        return false;
+
+      if (end - s <= more || u[1] < lo || u[1] > hi)
+        return false;
+      for (int ii = 2 ; ii <= more ; ii++)
+        if (u[ii] < 0x80 || u[ii] > 0xbf)
+          return false;
+      s += more + 1;
+      return true;
+    }
+
+    /* Checks text against the JSON grammar without building anything.
+       It is stricter than the parsers: whitespace is only what RFC 8259
+       allows, strings must be UTF-8 without raw control characters,
+       numbers must have the form the RFC gives them and nothing but
+       whitespace and comments may follow the value. Every read is
+       bounded by the length of the text rather than by a NUL.
+       Containers are tracked one bit per level, so no memory is
+       allocated and nesting is limited to DEFAULT_MAX_DEPTH. */
+    class Validator
+    {
+    public:
+      Validator(const char* text, size_t length)
+        : input(text), end(text + length), depth(0), code(E_NONE), at(NULL) {}
+
+      Error run()
+      {
+        const char* p = input;
+        if (value(p))
+        {
+          skip(p);
+          if (p != end)
+            fail(E_UNEXPECTED_CHARACTER, p);
+        }
+        return code == E_NONE ? Error() : Error(code, at - input, input);
+      }
+
+    private:
+      const char* input;
+      const char* end;
+      size_t depth;
+      uint64_t objects[DEFAULT_MAX_DEPTH / 64];  // bit set for each level that is an object
+      ErrorCode code;
+      const char* at;
+
+      bool fail(ErrorCode c, const char* p)
+      {
+        code = p == end && c >= E_UNEXPECTED_CHARACTER && c <= E_WRONG_TYPE ? E_UNEXPECTED_END : c;
+        at = p;
+        return false;
+      }
+
+      bool is(const char* p, char c) const
+      {
+        return p < end && *p == c;
+      }
+
+      bool digit(const char* p) const
+      {
+        return p < end && isDigit(*p);
+      }
+
+      /* Skip the whitespace of RFC 8259, ' ', '\t', '\n' and '\r', and
+         comments */
+      void skip(const char*& p)
+      {
+        while (p < end)
+        {
+          if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+            p++;
+          else if (*p == '/' && is(p + 1, '/'))
+          {
+            const char* eol = static_cast<const char*>(memchr(p + 2, '\n', end - p - 2));
+            p = eol ? eol + 1 : end;
+          }
+          else
+            break;
+        }
+      }
+
+      bool inObject() const
+      {
+        return (objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+      }
+
+      bool open(const char*& p, bool object)
+      {
+        if (depth == DEFAULT_MAX_DEPTH)
+          return fail(E_TOO_DEEP, p);
+        uint64_t bit = (uint64_t) 1 << (depth % 64);
+        objects[depth / 64] = object ? objects[depth / 64] | bit : objects[depth / 64] & ~bit;
+        depth++;
+        p++;
+        skip(p);
+        return true;
+      }
+
+      /* Check one value and every value inside it, leaving p just past
+         it. Nesting is followed with the bit stack rather than by
+         recursion. */
+      bool value(const char*& p)
+      {
+        while (1)
+        {
+          skip(p);
+          if (p == end)
+            return fail(E_UNEXPECTED_END, p);
+          bool ok;
+          switch (*p)
+          {
+          case '{':
+            if (!open(p, true))
+              return false;
+            if (!is(p, '}'))
+            {
+              if (!key(p))
+                return false;
+              continue;
+            }
+            ok = true;
+            break;
+          case '[':
+            if (!open(p, false))
+              return false;
+            if (!is(p, ']'))
+              continue;
+            ok = true;
+            break;
+          case '"':
+            ok = string(p);
+            break;
+          case 't':
+            ok = literal(p, "true", 4);
+            break;
+          case 'f':
+            ok = literal(p, "false", 5);
+            break;
+          case 'n':
+            ok = literal(p, "null", 4);
+            break;
+          default:
+            ok = number(p);
+          }
+          if (!ok)
+            return false;
+
+          // Close every container this value ends, then move on to the
+          // next member or element
+          while (1)
+          {
+            if (!depth)
+              return true;
+            skip(p);
+            char closer = inObject() ? '}' : ']';
+            if (is(p, closer))
+            {
+              p++;
+              depth--;
+              continue;
+            }
+            if (!is(p, ','))
+              return fail(E_EXPECTED_SEPARATOR, p);
+            p++;
+            if (closer == '}' && !key(p))
+              return false;
+            break;
+          }
+        }
+      }
+
+      /* Check an object key and the ':' after it */
+      bool key(const char*& p)
+      {
+        skip(p);
+        if (!is(p, '"'))
+          return fail(E_EXPECTED_KEY, p);
+        if (!string(p))
+          return false;
+        skip(p);
+        if (!is(p, ':'))
+          return fail(E_EXPECTED_COLON, p);
+        p++;
+        return true;
+      }
+
+      bool string(const char*& p)
+      {
+        const char* begin = p++;
+        while (1)
+        {
+          p = findStringSpecial(p, end);
+          if (p == end)
+            return fail(E_UNTERMINATED_STRING, begin);
+          unsigned char c = *p;
+          if (c == '"')
+          {
+            p++;
+            return true;
+          }
+          if (c == '\\')
+          {
+            uint32_t cp;
+            if (end - p < 2)
+              return fail(E_UNTERMINATED_STRING, begin);
+            if (p[1] && strchr("\"\\/bfnrt", p[1]))
+              p += 2;
+            else if (p[1] == 'u' && end - p >= 6 && parseHex4(p + 2, cp))
+              p += 6;
+            else
+              return fail(E_INVALID_ESCAPE, p);
+          }
+          else if (c >= 0x80)
+          {
+            if (!skipUtf8(p, end))
+              return fail(E_INVALID_UTF8, p);
+          }
+          else
+            return fail(E_UNEXPECTED_CHARACTER, p);
+        }
+      }
+
+      /* A number or literal must not run on into more letters or digits */
+      bool token(const char*& p, const char* q, const char* begin)
+      {
+        if (q < end && (isalnum((unsigned char) *q) || *q == '.' || *q == '+' || *q == '-'))
+          return fail(E_INVALID_LITERAL, begin);
+        p = q;
+        return true;
+      }
+
+      bool literal(const char*& p, const char* word, size_t length)
+      {
+        if ((size_t) (end - p) < length || memcmp(p, word, length))
+          return fail(E_INVALID_LITERAL, p);
+        return token(p, p + length, p);
+      }
+
+      bool number(const char*& p)
+      {
+        const char* q = p;
+        if (is(q, '-'))
+          q++;
+        if (is(q, '0'))
+          q++;
+        else if (digit(q))
+          while (digit(q))
+            q++;
+        else
+          return q == p ? fail(E_UNEXPECTED_CHARACTER, p) : fail(E_INVALID_LITERAL, p);
+        if (is(q, '.'))
+        {
+          if (!digit(++q))
+            return fail(E_INVALID_LITERAL, p);
+          while (digit(q))
+            q++;
+        }
+        if (is(q, 'e') || is(q, 'E'))
+        {
+          q++;
+          if (is(q, '+') || is(q, '-'))
+            q++;
+          if (!digit(q))
+            return fail(E_INVALID_LITERAL, p);
+          while (digit(q))
+            q++;
+        }
+        return token(p, q, p);
+      }
+    };
+
+  }; // namespace
+
+  /* Check that the length bytes of text are well-formed JSON without
+     parsing them into anything and without allocating: structure,
+     strings, escape sequences, UTF-8, numbers and literals. Nothing
+     past length is read, so text need not be NUL-terminated, and a NUL
+     within it is an error. Returns an Error with code E_NONE if the
+     text is valid. Comments are accepted as everywhere else, and
+     containers may nest at most DEFAULT_MAX_DEPTH deep. lastError() is
+     left alone. */
+  inline Error validate(const char* text, size_t length)
+  {
+    return impl::Validator(text, length).run();
+  }
+
+  inline Error validate(const char* text)
+  {
+    return validate(text, strlen(text));
+  }
+
+  /* Parses JSON that arrives in pieces, calling handler with the same
+     events as Json::parse. Each call to feed() takes the next chunk of
+     input, which may end anywhere, even inside a string, number or
+     escape sequence: the parser saves its state and resumes with the
+     next chunk, keeping only the unfinished token. Events are reported
+     as soon as the input completing them arrives, so a container's end
+     event follows its closing bracket in the same feed() call. The
+     input may hold any number of top-level values in a row, such as
+     JSON Lines. Nothing but open containers is held on the stack. */
+  template<typename _Handler>
+  class PushParser
+  {
+  public:
+    PushParser(_Handler& h, size_t depth = DEFAULT_MAX_DEPTH) : handler(h), maxDepth(depth) { reset(); }
+
+    /* Parse the next length bytes of input. Returns false if the input
+       is malformed or the handler stopped the parse; the parser then
+       rejects further input until reset(). */
+    bool feed(const char* data, size_t length)
+    {
+      if (failed)
+        return false;
+
+      const char* p = data;
+      const char* end = data + length;
+      mark = p;
+
+      while (p < end)
+      {
+        switch (lex)
+        {
+        case X_STRING:
+          if (!continueString(p, end))
+            return fail(p - data);
+          continue;
+        case X_LITERAL:
+          if (!continueLiteral(p, end))
+            return fail(p - data);
+          continue;
+        case X_SLASH:
+          if (*p != '/')
+          {
+            reject(E_UNEXPECTED_CHARACTER);
+            return fail(p - data);
+          }
+          lex = X_COMMENT;
+          p++;
+          continue;
+        case X_COMMENT:
+          p = static_cast<const char*>(memchr(p, '\n', end - p));
+          if (!p)
+          {
+            consumed += length;
+            return true;
+          }
+          lex = X_NONE;
+          p++;
+          continue;
+        default:
+          break;
+        }
+
+        char c = *p;
+        if (impl::isSpace(c))
+          p++;
+        else if (c == '/') {
+          lex = X_SLASH;
+          p++;
+        }
+        else if (!structural(p))
+          return fail(p - data);
+      }
+
+      if (lex == X_STRING || lex == X_LITERAL)
+        token.append(mark, end);
+      consumed += length;
+      return true;
+    }
+
+    /* Signal the end of the input, completing a number at the very end.
+       Returns false if a value is still incomplete. The parser is reset
+       either way, ready for another stream. */
+    bool finish()
+    {
+      bool ok = !failed;
+      if (ok && lex == X_LITERAL)
+        ok = endLiteral();
+      if (ok && ((lex != X_NONE && lex != X_COMMENT) || !stack.empty()))
+        ok = reject(E_UNEXPECTED_END);
+      if (!ok && !failed)
+        fail(0);
+      reset();
+      return ok;
+    }
+
+    /* Discard any partial input and start over */
+    void reset()
+    {
+      stack.clear();
+      token.clear();
+      state = S_VALUE;
+      lex = X_NONE;
+      key = escaped = backslash = failed = false;
+      consumed = 0;
+    }
+
+    /* Number of containers currently open */
+    size_t depth() const { return stack.size(); }
+
+    /* The last failure. Its offset counts the bytes fed since the
+       stream started; the input is not kept, so it has no line or
+       column. */
+    const Error& error() const { return err; }
+
+  private:
+    /* What is expected next between tokens */
+    typedef enum
+    {
+      S_VALUE, S_VALUE_OR_END, S_KEY_OR_END, S_COLON, S_COMMA_OR_END
+    }
+    State;
+
+    /* The token being read, if any */
+    typedef enum
+    {
+      X_NONE, X_STRING, X_LITERAL, X_SLASH, X_COMMENT
+    }
+    Lexeme;
+
+    _Handler& handler;
+    size_t maxDepth;
+    std::vector<char> stack;
+    State state;
+    Lexeme lex;
+
+    /* An unfinished string or literal is the bytes saved in token from
+       earlier chunks followed by those from mark in the current one */
+    std::string token;
+    std::string scratch;
+    const char* mark;
+    bool key;
+    bool escaped;
+    bool backslash;
+    bool failed;
+    size_t consumed;
+    Error err;
+
+    /* Record why the parse is failing, for fail() to locate */
+    bool reject(ErrorCode code)
+    {
+      err.code = code;
+      return false;
+    }
+
+    /* Stop at offset bytes into the current chunk */
+    bool fail(size_t offset)
+    {
+      err.offset = consumed + offset;
+      failed = true;
+      return false;
+    }
+
+    void endValue()
+    {
+      state = stack.empty() ? S_VALUE : S_COMMA_OR_END;
+    }
+
+    bool close(char open)
+    {
+      stack.pop_back();
+      endValue();
+      return (open == '{' ? handler.endObject() : handler.endArray()) || reject(E_HANDLER);
+    }
+
+    bool structural(const char*& p)
+    {
+      char c = *p;
+      if ((c == '{' || c == '[') && stack.size() >= maxDepth)
+        return reject(E_TOO_DEEP);
+      switch (state)
+      {
+      case S_VALUE_OR_END:
+        if (c == ']') {
+          p++;
+          return close('[');
+        }
+        // fall through
+      case S_VALUE:
+        if (c == '{') {
+          p++;
+          stack.push_back('{');
+          state = S_KEY_OR_END;
+          return handler.startObject() || reject(E_HANDLER);
+        }
+        if (c == '[') {
+          p++;
+          stack.push_back('[');
+          state = S_VALUE_OR_END;
+          return handler.startArray() || reject(E_HANDLER);
+        }
+        if (c == '"')
+          return startString(p, false);
+        if (isalnum((unsigned char) c) || c == '-') {
+          lex = X_LITERAL;
+          mark = p;
+          return true;
+        }
+        return reject(E_UNEXPECTED_CHARACTER);
+      case S_KEY_OR_END:
+        if (c == '}') {
+          p++;
+          return close('{');
+        }
+        if (c == '"')
+          return startString(p, true);
+        return reject(E_UNEXPECTED_CHARACTER);
+      case S_COLON:
+        if (c != ':')
+          return reject(E_EXPECTED_COLON);
+        p++;
+        state = S_VALUE;
+        return true;
+      case S_COMMA_OR_END:
+        p++;
+        // a closing bracket may follow the comma, as impl::Reader allows
+        if (c == ',') {
+          state = stack.back() == '{' ? S_KEY_OR_END : S_VALUE_OR_END;
+          return true;
+        }
+        if (c == (stack.back() == '{' ? '}' : ']'))
+          return close(stack.back());
+        p--;
+        return reject(E_EXPECTED_SEPARATOR);
+      }
+      return false;
+    }
+
+    bool startString(const char*& p, bool isKey)
+    {
+      p++;
+      lex = X_STRING;
+      mark = p;
+      key = isKey;
+      escaped = backslash = false;
+      return true;
+    }
+
+    /* Scan for the closing quote, remembering across chunks whether the
+       last byte seen was a backslash */
+    bool continueString(const char*& p, const char* end)
+    {
+      while (p < end)
+      {
+        if (backslash) {
+          backslash = false;
+          p++;
+          continue;
+        }
+
+        const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+        const char* stop = quote ? quote : end;
+        const char* bs = static_cast<const char*>(memchr(p, '\\', stop - p));
+        if (bs) {
+          escaped = backslash = true;
+          p = bs + 1;
+          continue;
+        }
+        if (!quote) {
+          p = end;
+          return true;
+        }
+
+        const char* begin = mark;
+        size_t length = quote - mark;
+        if (!token.empty()) {
+          token.append(mark, quote);
+          begin = token.data();
+          length = token.size();
+        }
+
+        if (escaped) {
+          scratch.resize(length);
+          if (!impl::unescape(begin, begin + length, &scratch[0], length))
+            return reject(E_INVALID_ESCAPE);
+          begin = scratch.data();
+        }
+
+        p = quote + 1;
+        lex = X_NONE;
+        bool ok;
+        if (key) {
+          state = S_COLON;
+          ok = handler.key(begin, length);
+        }
+        else {
+          endValue();
+          ok = handler.string(begin, length);
+        }
+        token.clear();
+        return ok || reject(E_HANDLER);
+      }
+      return true;
+    }
+
+    static bool isLiteralChar(char c)
+    {
+      return isalnum((unsigned char) c) || c == '-' || c == '+' || c == '.' || c == '_';
+    }
+
+    bool continueLiteral(const char*& p, const char* end)
+    {
+      while (p < end && isLiteralChar(*p))
+        p++;
+      if (p == end)
+        return true;
+
+      token.append(mark, p);
+      return endLiteral();
+    }
+
+    /* Parse the literal saved in token */
+    bool endLiteral()
+    {
+      char* s = const_cast<char*>(token.c_str());
+      impl::ParsedNumber num;
+      impl::Literal literal = impl::scanLiteral(s, num);
+      ErrorCode code = literal == impl::L_INVALID ? impl::failure().code : E_INVALID_LITERAL;
+      if (*s)
+        literal = impl::L_INVALID;
+      token.clear();
+      lex = X_NONE;
+      if (literal == impl::L_INVALID)
+        return reject(code);
+      endValue();
+      return impl::sendLiteral(handler, literal, num) || reject(E_HANDLER);
+    }
+  };
+
+  /* Why the last read, parse, decode or extract on this thread failed.
+     Like errno it is only meaningful right after a failure, and its
+     input is the text that was being parsed, if that is still alive. */
+  inline Error lastError()
+  {
+    return impl::lastError();
+  }
+
+  /* Read a JSON Value from a string of characters */
+  inline Value* read(const char* s)
+  {
+    impl::begin(s);
+    char* p = (char*) s;
+    return impl::parseGeneric(p);
+  }
+
+  /* Read a JSON Value from a string of characters. Returns true if 
+     parsing succeeds and top-level Value type matches the type of _T */
+  template<typename _T>
+  bool read(const char* s, const _T*& out)
+  {
+    Value* parsed = read(s);
+    if (parsed && parsed->getType() == _T::TYPE)
+    {
+      out = static_cast<const _T*>(parsed);
+      return true;
+    }
+    if (parsed)
+    {
+      char* p = (char*) s;
+      impl::chomp(p);
+      impl::fail(E_WRONG_TYPE, p);
+    }
+    delete parsed;
+    return false;
+  }
+
+  /* Read a JSON Value from a file, parsing it straight from a memory
+     mapping rather than a copy of its contents. The offset of an error
+     is kept, but not its line and column. */
+  inline Value* readFile(const char* path)
+  {
+    impl::MappedFile file;
+    impl::begin(NULL);
+    if (!file.open(path))
+      return NULL;
+    Value* parsed = read(file.data());
+    impl::detach();
+    return parsed;
+  }
+
+  /* Read a JSON Value from a file. Returns true if parsing succeeds
+     and top-level Value type matches the type of _T */
+  template<typename _T>
+  bool readFile(const char* path, const _T*& out)
+  {
+    Value* parsed = readFile(path);
+    if (parsed && parsed->getType() == _T::TYPE)
+    {
+      out = static_cast<const _T*>(parsed);
+      return true;
+    }
+    if (parsed)
+      impl::fail(E_WRONG_TYPE, NULL);
+    delete parsed;
+    return false;
+  }
+
+  /* Write a JSON Value to a std::stringstream */
+  inline void write(const Value* value, std::stringstream& ss) {
+    impl::formatGeneric(value, ss);
+  }
+
+  /* Write a JSON Value and return a std::string containing the 
+     formatted data */
+  inline std::string write(const Value* value) {
+    std::stringstream ss;
+    write(value, ss);
+    return ss.str();
+  }
+
+  /* Write a Document node to a std::stringstream */
+  inline void write(const dom::Node& node, std::stringstream& ss) {
+    impl::formatGeneric(node, ss);
+  }
+
+  /* Write a Document node and return a std::string containing the
+     formatted data */
+  inline std::string write(const dom::Node& node) {
+    std::stringstream ss;
+    write(node, ss);
+    return ss.str();
+  }
+
+  /* A parsed JSON document. Every node, key and string of the tree is
+     placed in the Document's own Arena and released together with it,
+     so there is nothing to delete node by node.
+
+     A Document can parse one input after another, each replacing the
+     tree of the last. It keeps its memory from one parse to the next:
+     the Arena's blocks, the structural index and the builder's scratch
+     stacks are all reused, so a Document that parses many similar
+     messages stops allocating once it has seen the largest of them. */
+  class Document
+  {
+  public:
+    Document() : builder(pool), keys(NULL), workers(0), maxDepth(DEFAULT_MAX_DEPTH), parsed(false) {}
+
+    /* Parse a string of characters, replacing any previous contents.
+       Returns false if the input is malformed. With P_ZERO_COPY, string
+       values and keys point into s, which must outlive the Document;
+       escape sequences are only decoded when a string is read.
+
+       With P_LAZY only the top-level value is built: the containers in
+       it are checked without being built, and built one level at a time
+       when a dom::Array or dom::Object view is first made of them.
+       Malformed input fails the parse as it would without P_LAZY. s must
+       then outlive the Document too. Reading a lazy Document changes
+       it, so threads sharing one need a lock. P_PARALLEL is ignored. */
+    bool parse(const char* s, int flags = P_DEFAULT)
+    {
+      file.close();
+      return parse((char*) s, strlen(s), flags & ~P_INSITU);
+    }
+
+    /* Parse a buffer the caller is done with, destroying its contents:
+       strings and keys are decoded and NUL-terminated in place, so none
+       of them is copied. buf holds length bytes followed by a NUL and
+       must outlive the Document. */
+    bool parseInsitu(char* buf, size_t length, int flags = P_DEFAULT)
+    {
+      file.close();
+      return parse(buf, length, flags | P_INSITU);
+    }
+
+    /* Parse the contents of a file straight from a memory mapping that
+       the Document keeps until its next parse. By default strings and
+       keys are views into the mapping, as with P_ZERO_COPY; P_INSITU
+       decodes them in a private copy-on-write mapping instead. */
+    bool parseFile(const char* path, int flags = P_ZERO_COPY)
+    {
+      parsed = false;
+      pool.reset();
+      impl::begin(NULL);
+      if (!file.open(path, (flags & P_INSITU) != 0))
       {
-      case T_NUMBER:
-        formatNumber(static_cast<const Number*>(obj), out);
-        break;
-      case T_STRING:
-        formatString(static_cast<const String*>(obj), out);
-        break;
-      case T_BOOLEAN:
-        formatBoolean(static_cast<const Boolean*>(obj), out);
-        break;
-      case T_ARRAY:
-        formatArray(static_cast<const Array*>(obj), out);
-        break;
-      case T_OBJECT:
-        formatObject(static_cast<const Object*>(obj), out);
-        break;
+        err = impl::lastError();
+        return false;
+      }
+      return parse(file.data(), file.size(), flags);
+    }
+
+    /* Intern object keys in table on every following parse, or stop
+       doing so if table is NULL. The table must outlive the Document. */
+    void setKeyTable(KeyTable* table) { keys = table; }
+
+    /* Number of threads parsing with P_PARALLEL, by default as many as
+       the hardware runs at once */
+    void setThreads(unsigned count) { workers = count; }
+
+    /* Fail on containers nested more than depth deep */
+    void setMaxDepth(size_t depth) { maxDepth = depth; }
+
+    /* The top-level node, or NULL if nothing was parsed successfully */
+    const dom::Node* root() const { return parsed ? &top : NULL; }
+
+    /* Why the last parse failed, or E_NONE if it succeeded. Its line
+       and column are counted in the input, which must still be alive. */
+    const Error& error() const { return err; }
+
+    /* Returns true if the top-level node holds a value of the type
+       of _T, storing it in out */
+    template<typename _T>
+    bool root(_T& out) const
+    {
+      return parsed && top.as(out);
+    }
+
+  private:
+    impl::Arena pool;
+    impl::DocumentBuilder builder;
+    impl::MappedFile file;
+    std::vector<uint32_t> structurals;
+    std::vector<const char*> cuts;
+    KeyTable* keys;
+    unsigned workers;
+    size_t maxDepth;
+    dom::Node top;
+    bool parsed;
+    Error err;
+
+    bool parse(char* s, size_t length, int flags)
+    {
+      pool.reset();
+      impl::begin(s);
+      builder.configure(flags, keys, maxDepth);
+      parsed = build(s, length, flags);
+      err = parsed ? Error() : impl::lastError();
+      return parsed;
+    }
+
+    bool build(char* s, size_t length, int flags)
+    {
+      if (flags & P_LAZY)
+        return builder.parseGeneric(s, top);
+#if defined(JSONPARSER_CXX11)
+      unsigned threads = workers ? workers : std::thread::hardware_concurrency();
+      char* open = s;
+      impl::chomp(open);
+      if ((flags & P_PARALLEL) && threads > 1 && maxDepth > 0 && length >= impl::PARALLEL_MIN
+          && *open == '[' && impl::findArrayCuts(open, length - (open - s), threads, cuts))
+        return impl::parseArrayParts(open, cuts, pool, flags, keys, maxDepth, top);
+#endif
+      if (impl::indexStructurals(s, length, structurals))
+        return builder.parseIndexed(s, structurals, top);
+      return builder.parseGeneric(s, top);
+    }
+
+    Document(const Document&);
+    Document& operator=(const Document&);
+  };
+
+#if defined(JSONPARSER_CXX11)
+  namespace impl {
+
+    /* Parses the JSON Lines records of one slice of a buffer into its
+       own Arena, so that slices can be parsed on separate threads */
+    class LineWorker
+    {
+    public:
+      std::vector<const dom::Node*> records;
+      size_t errors;
+      Failure first;  // the failure of the first malformed record
+
+      std::exception_ptr thrown;  // such as std::bad_alloc, rethrown by the calling thread
+
+      LineWorker() : errors(0), builder(arena) {}
+
+      /* Parse the lines in [begin, end). Each line holds one record;
+         blank lines and lines holding only a comment are skipped, and a
+         malformed record is stored as NULL. A record running past the end
+         of its line is malformed, but may be read as far as the NUL
+         terminating the whole buffer. */
+      void parse(const char* begin, const char* end, int flags, KeyTable* keys)
+      {
+        thrown = std::exception_ptr();
+        try {
+          parseLines(begin, end, flags, keys);
+        }
+        catch (...) {
+          thrown = std::current_exception();
+        }
+      }
+
+    private:
+      Arena arena;
+      DocumentBuilder builder;
+
+      void parseLines(const char* begin, const char* end, int flags, KeyTable* keys)
+      {
+        arena.reset();
+        records.clear();
+        errors = 0;
+        impl::begin(NULL);
+        first = failure();
+        builder.configure(flags & ~(P_INSITU | P_LAZY), keys, DEFAULT_MAX_DEPTH);
+
+        for (const char* line = begin ; line < end ; )
+        {
+          const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+          if (!eol)
+            eol = end;
+
+          char* s = (char*) line;
+          line = eol + 1;
+          while (s < eol && isSpace(*s))
+            s++;
+          if (s == eol || (*s == '/' && s + 1 < eol && *(s + 1) == '/'))
+            continue;
+
+          dom::Node* root = arena.allocate<dom::Node>(1);
+          bool ok = builder.parseGeneric(s, *root);
+          while (ok && s < eol && isSpace(*s))
+            s++;
+          if (ok && s + 1 < eol && *s == '/' && *(s + 1) == '/')
+            s = (char*) eol;
+          if (ok && s != eol)
+            ok = fail(E_UNEXPECTED_CHARACTER, s);
+          if (!ok)
+          {
+            root = NULL;
+            if (!errors++)
+              first = failure();
+          }
+          records.push_back(root);
+        }
+      }
+    };
+
+    /* Start of the line following the one containing p */
+    inline const char* nextLine(const char* p, const char* end)
+    {
+      const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+      return eol ? eol + 1 : end;
+    }
+
+  }; // namespace
+
+  /* Parses a buffer of JSON Lines (one JSON value per line) on several
+     threads at once. The buffer is cut into one slice per thread at
+     line boundaries, and each thread parses the records of its slice
+     into an Arena of its own; the records are then available in input
+     order. Only available with C++11. */
+  class LineBatch
+  {
+  public:
+    /* threads defaults to the number of hardware threads */
+    LineBatch(unsigned threads = 0) : keys(NULL), errors(0)
+    {
+      if (!threads)
+        threads = std::thread::hardware_concurrency();
+      for (unsigned ii = 0 ; ii < (threads ? threads : 1) ; ii++)
+        workers.push_back(std::unique_ptr<impl::LineWorker>(new impl::LineWorker()));
+    }
+
+    /* Intern object keys in table, which every thread shares */
+    void setKeyTable(KeyTable* table) { keys = table; }
+
+    /* Parse every record of data, which holds length bytes followed by
+       a NUL, replacing any previous records. Returns false if any record
+       is malformed. With P_ZERO_COPY strings point into data, which must
+       then outlive the records; P_INSITU is not supported. An exception
+       thrown while parsing a slice is rethrown here once every thread
+       has finished; a slice whose thread cannot be started is parsed on
+       this one. */
+    bool parse(const char* data, size_t length, int flags = P_DEFAULT)
+    {
+      const char* end = data + length;
+      size_t count = length < MIN_SLICE ? 1 : std::min(workers.size(), length / MIN_SLICE);
+
+      std::vector<std::thread> threads;
+      threads.reserve(count);
+
+      // nothing below may throw while a thread is running
+      const char* begin = data;
+      for (size_t ii = 0 ; ii < count ; ii++)
+      {
+        const char* last = ii + 1 == count ? end : impl::nextLine(data + length / count * (ii + 1), end);
+        if (last < begin)
+          last = begin;
+        impl::LineWorker* worker = workers[ii].get();
+        bool started = false;
+        if (ii + 1 < count)
+        {
+          try {
+            threads.push_back(std::thread(&impl::LineWorker::parse, worker, begin, last, flags, keys));
+            started = true;
+          }
+          catch (const std::system_error&) {
+          }
+        }
+        if (!started)
+          worker->parse(begin, last, flags, keys);
+        begin = last;
+      }
+      for (size_t ii = 0 ; ii < threads.size() ; ii++)
+        threads[ii].join();
+
+      for (size_t ii = 0 ; ii < count ; ii++)
+      {
+        if (workers[ii]->thrown)
+          std::rethrow_exception(workers[ii]->thrown);
+      }
+
+      records.clear();
+      errors = 0;
+      err = Error();
+      for (size_t ii = 0 ; ii < count ; ii++)
+      {
+        const impl::LineWorker& worker = *workers[ii];
+        records.insert(records.end(), worker.records.begin(), worker.records.end());
+        if (!errors && worker.errors)
+          err = worker.first.at ? Error(worker.first.code, worker.first.at - data, data)
+                                : Error(worker.first.code, 0);
+        errors += worker.errors;
+      }
+      return errors == 0;
+    }
+
+    /* Number of records, not counting blank lines */
+    size_t size() const { return records.size(); }
+
+    /* Number of malformed records */
+    size_t errorCount() const { return errors; }
+
+    /* Why the first malformed record failed, its offset counted from
+       the start of data; E_NONE if every record parsed */
+    const Error& error() const { return err; }
+
+    /* The record at idx, or NULL if it is malformed */
+    const dom::Node* get(size_t idx) const { return records[idx]; }
+    const dom::Node* operator[](size_t idx) const { return records[idx]; }
+
+    /* Returns true if the record at idx holds a value of the type of
+       _T, storing it in out */
+    template<typename _T>
+    bool get(size_t idx, _T& out) const
+    {
+      return records[idx] && records[idx]->as(out);
+    }
+
+  private:
+    /* Slices are kept large enough for a thread to be worth starting */
+    static const size_t MIN_SLICE = 1 << 16;
+
+    std::vector<std::unique_ptr<impl::LineWorker> > workers;
+    std::vector<const dom::Node*> records;
+    KeyTable* keys;
+    size_t errors;
+    Error err;
+
+    LineBatch(const LineBatch&);
+    LineBatch& operator=(const LineBatch&);
+  };
+
+  /* Reads the records of a large buffer of JSON Lines one at a time,
+     parsing them window by window with a LineBatch. The next window is
+     parsed in the background while the records of the current one are
+     handed out, so reading keeps every core busy and only two windows
+     of records are held at once. */
+  class LineIterator
+  {
+  public:
+    /* data holds length bytes followed by a NUL and must outlive the
+       LineIterator. window is the number of bytes parsed at a time. */
+    LineIterator(const char* data, size_t length, int parseFlags = P_DEFAULT,
+                 unsigned threads = 0, size_t windowSize = 1 << 24)
+      : pos(data), end(data + length), flags(parseFlags), window(windowSize), current(0), next(0),
+        waiting(false)
+    {
+      batches[0].reset(new LineBatch(threads));
+      batches[1].reset(new LineBatch(threads));
+      startWindow();
+    }
+
+    ~LineIterator()
+    {
+      if (pending.joinable())
+        pending.join();
+    }
+
+    /* Move to the next record, storing it in record: NULL if it is
+       malformed. Returns false once every record has been read. The
+       record remains valid until the following call. An exception
+       thrown while parsing a window, such as std::bad_alloc, is rethrown
+       here when its records are reached. */
+    bool read(const dom::Node*& record)
+    {
+      while (next == batches[current]->size())
+      {
+        if (!waiting)
+          return false;
+        if (pending.joinable())
+          pending.join();
+        waiting = false;
+        if (thrown)
+        {
+          std::exception_ptr e = thrown;
+          thrown = std::exception_ptr();
+          std::rethrow_exception(e);
+        }
+        current ^= 1;
+        next = 0;
+        startWindow();
+      }
+      record = batches[current]->get(next++);
+      return true;
+    }
+
+  private:
+    std::unique_ptr<LineBatch> batches[2];
+    std::thread pending;
+    const char* pos;
+    const char* end;
+    int flags;
+    size_t window;
+    size_t current;
+    size_t next;
+    bool waiting;               // a window is being parsed into the other batch
+    std::exception_ptr thrown;  // thrown while parsing it, rethrown by read()
+
+    void parseWindow(LineBatch* batch, const char* begin, size_t length)
+    {
+      try {
+        batch->parse(begin, length, flags);
+      }
+      catch (...) {
+        thrown = std::current_exception();
+      }
+    }
+
+    /* Start parsing the window following the current one into the
+       other batch, on this thread if no other can be started */
+    void startWindow()
+    {
+      if (pos == end)
+        return;
+      const char* begin = pos;
+      const char* last = (size_t) (end - pos) <= window ? end : impl::nextLine(pos + window, end);
+      LineBatch* batch = batches[current ^ 1].get();
+      pos = last;
+      waiting = true;
+      try {
+        pending = std::thread(&LineIterator::parseWindow, this, batch, begin, (size_t) (last - begin));
+        return;
+      }
+      catch (const std::system_error&) {
+      }
+      parseWindow(batch, begin, last - begin);
+    }
+
+    LineIterator(const LineIterator&);
+    LineIterator& operator=(const LineIterator&);
+  };
+#endif
+
+  /* A position in JSON text that is parsed only as far as it is read.
+     Looking up a key or an index scans the enclosing container from its
+     start, stepping over the values it passes by bracket matching, and
+     reading a value decodes just that value. Nothing is allocated, and
+     text that is skipped is not validated. A lookup that fails, on a
+     missing key or malformed input, gives an invalid Cursor, and so do
+     lookups on an invalid Cursor, so a chain only needs to be checked
+     at its end:
+
+       double latency;
+       if (!Json::Cursor(text)["events"][ii]["latency"].as(latency))
+
+     The text must be NUL-terminated and outlive the Cursor. Duplicate
+     keys resolve to their first occurrence. Walking a container with
+     first() and next() passes over it once, where indexing each
+     element in turn would rescan it. */
+  class Cursor
+  {
+  public:
+    Cursor() : s(NULL), k(NULL) {}
+    explicit Cursor(const char* text) : s(NULL), k(NULL)
+    {
+      char* p = (char*) text;
+      impl::chomp(p);
+      if (*p)
+        s = p;
+    }
+
+    bool valid() const { return s != NULL; }
+
+    /* The type of the value, judged by its first character. Invalid
+       Cursors report T_NULL. */
+    Type getType() const
+    {
+      if (!s) return T_NULL;
+      switch (*s)
+      {
+      case '{': return T_OBJECT;
+      case '[': return T_ARRAY;
+      case '"': return T_STRING;
+      case 't': case 'f': return T_BOOLEAN;
+      case 'n': return T_NULL;
+      default: return T_NUMBER;
+      }
+    }
+
+    bool isNull() const { return s && *s == 'n'; }
+
+    /* The member of an object with the given key */
+    Cursor operator[](const char* key) const { return find(key, strlen(key)); }
+    Cursor operator[](const std::string& key) const { return find(key.data(), key.size()); }
+
+    /* The element of an array at the given index */
+    Cursor operator[](size_t idx) const
+    {
+      Cursor c = first(T_ARRAY);
+      while (idx-- > 0 && c.s)
+        c = c.next();
+      return c;
+    }
+    Cursor operator[](int idx) const { return idx < 0 ? Cursor() : (*this)[(size_t) idx]; }
+
+    /* The first element of an array or member value of an object */
+    Cursor first() const { return first(getType() == T_OBJECT ? T_OBJECT : T_ARRAY); }
+
+    /* The element or member following this one in its container */
+    Cursor next() const
+    {
+      char* p = s;
+      if (!p || !impl::skipValue(p))
+        return Cursor();
+      impl::chomp(p);
+      if (*p != ',')
+        return Cursor();
+      p++;
+      return k ? member(p) : element(p);
+    }
+
+    /* The raw key of a member reached with first() and next() */
+    bool key(StringRef& out) const
+    {
+      if (!k) return false;
+      char* p = k;
+      const char* begin;
+      size_t length;
+      bool escaped;
+      if (!impl::scanCharString(p, begin, length, escaped)) return false;
+      out = StringRef(begin, length, escaped);
+      return true;
+    }
+
+    /* Number of elements or members, found by stepping over them */
+    size_t size() const
+    {
+      size_t count = 0;
+      for (Cursor c = first() ; c.s ; c = c.next())
+        count++;
+      return count;
+    }
+
+    /* Typed getters. Each returns true if the Cursor is at a value of
+       the requested type and stores it in out. Strings read as StringRef
+       are not copied; like P_ZERO_COPY strings they may be escaped. */
+    bool as(double& out) const { dom::Node n; return literal(n) && n.as(out); }
+    bool as(int64_t& out) const { dom::Node n; return literal(n) && n.as(out); }
+    bool as(uint64_t& out) const { dom::Node n; return literal(n) && n.as(out); }
+    bool as(bool& out) const { dom::Node n; return literal(n) && n.as(out); }
+
+    bool as(StringRef& out) const
+    {
+      if (getType() != T_STRING) return false;
+      char* p = s;
+      const char* begin;
+      size_t length;
+      bool escaped;
+      if (!impl::scanCharString(p, begin, length, escaped)
+          || (escaped && !impl::validEscapes(begin, begin + length)))
+        return false;
+      out = StringRef(begin, length, escaped);
+      return true;
+    }
+
+    bool as(std::string& out) const
+    {
+      StringRef ref;
+      if (!as(ref)) return false;
+      out = ref.str();
+      return true;
+    }
+
+    bool as(Cursor& out) const
+    {
+      if (!s) return false;
+      out = *this;
+      return true;
+    }
+
+    template<typename _T>
+    bool get(const char* key, _T& out) const { return (*this)[key].as(out); }
+
+    template<typename _T>
+    bool get(const std::string& key, _T& out) const { return (*this)[key].as(out); }
+
+    template<typename _T>
+    bool get(size_t idx, _T& out) const { return (*this)[idx].as(out); }
+
+  private:
+    /* s is the first character of the value, k the opening quote of
+       its key if it was reached as an object member */
+    char* s;
+    char* k;
+
+    Cursor(char* value, char* key) : s(value), k(key) {}
+
+    Cursor first(Type type) const
+    {
+      if (getType() != type) return Cursor();
+      char* p = s + 1;
+      impl::chomp(p);
+      if (*p == (type == T_OBJECT ? '}' : ']'))
+        return Cursor();
+      return type == T_OBJECT ? member(p) : element(p);
+    }
+
+    /* The element at p, or none at a closing bracket, as after the
+       trailing comma of "[1,]" */
+    static Cursor element(char* p)
+    {
+      impl::chomp(p);
+      return *p && *p != ']' && *p != '}' ? Cursor(p, NULL) : Cursor();
+    }
+
+    /* Read the key of the member at p, leaving p at its value. A
+       closing bracket where the key should be fails like any other
+       character that is not a quote. */
+    static bool readMember(char*& p, char*& key, StringRef& name)
+    {
+      impl::chomp(p);
+      key = p;
+      const char* begin;
+      size_t length;
+      bool escaped;
+      if (!impl::scanCharString(p, begin, length, escaped))
+        return false;
+      name = StringRef(begin, length, escaped);
+      impl::chomp(p);
+      if (*p != ':')
+        return false;
+      p++;
+      impl::chomp(p);
+      return *p != 0;
+    }
+
+    static Cursor member(char* p)
+    {
+      char* key;
+      StringRef name;
+      return readMember(p, key, name) ? Cursor(p, key) : Cursor();
+    }
+
+    Cursor find(const char* key, size_t length) const
+    {
+      if (getType() != T_OBJECT) return Cursor();
+      char* p = s + 1;
+      impl::chomp(p);
+      if (*p == '}') return Cursor();
+
+      while (1)
+      {
+        char* at;
+        StringRef name;
+        if (!readMember(p, at, name))
+          return Cursor();
+        if (name.escaped() ? name.str() == std::string(key, length)
+            : name.size() == length && memcmp(name.data(), key, length) == 0)
+          return Cursor(p, at);
+        if (!impl::skipValue(p))
+          return Cursor();
+        impl::chomp(p);
+        if (*p != ',')
+          return Cursor();
+        p++;
+      }
+    }
+
+    bool literal(dom::Node& out) const
+    {
+      Type type = getType();
+      if (!s || (type != T_NUMBER && type != T_BOOLEAN)) return false;
+      char* p = s;
+      impl::ParsedNumber num;
+      switch (impl::scanLiteral(p, num))
+      {
+      case impl::L_NUMBER:
+        if (num.kind == N_INT64)
+          out = dom::Node::makeInt64((int64_t) num.bits);
+        else if (num.kind == N_UINT64)
+          out = dom::Node::makeUInt64(num.bits);
+        else
+          out = dom::Node::makeNumber(num.d);
+        return true;
+      case impl::L_TRUE:
+      case impl::L_FALSE:
+        out = dom::Node::makeBoolean(*s == 't');
+        return true;
       default:
-        out << "???";
+        return false;
+      }
+    }
+  };
+
+  /* A set of RFC 6901 JSON Pointers, such as "/request/headers/host" or
+     "/metrics/3/value", compiled into a tree of the tokens they share.
+     extract() finds the values of all of them in one forward pass over
+     raw text, descending only into the members and elements that lead
+     to a pointer and stepping over everything else by bracket matching,
+     so no tree is built. It stops reading as soon as every pointer has
+     been found. As with Cursor, duplicate keys resolve to their first
+     occurrence and text that is skipped is not validated.
+
+     A PointerSet is not changed by extract(), so one set can serve
+     several threads at once. */
+  class PointerSet
+  {
+  public:
+    PointerSet() : count(0) { steps.push_back(Step()); }
+
+    /* Add a pointer, returning false if it is malformed. The empty
+       pointer refers to the whole text. Values are reported in the
+       order their pointers were added. */
+    bool add(const char* pointer) { return add(pointer, strlen(pointer)); }
+    bool add(const std::string& pointer) { return add(pointer.data(), pointer.size()); }
+
+    /* Number of pointers added */
+    size_t size() const { return count; }
+
+    /* Find the value of every pointer in text, which must be
+       NUL-terminated. out[ii] is left at the value of the ii-th pointer
+       added, or invalid if text has no such value. Returns false if the
+       text read on the way is malformed, see lastError(); values found
+       before that point are still set. */
+    bool extract(const char* text, std::vector<Cursor>& out) const
+    {
+      impl::begin(text);
+      out.assign(count, Cursor());
+      size_t left = count;
+      char* p = (char*) text;
+      return !left || visit(p, 0, out, left);
+    }
+
+  private:
+    /* A token of the compiled pointers. index is the array index the
+       token names, or NO_INDEX if it is not one; targets are the
+       pointers that end here. Step 0 is the root, so 0 never names a
+       child. */
+    struct Step
+    {
+      std::string token;
+      size_t index;
+      std::vector<size_t> children;
+      std::vector<size_t> targets;
+      Step() : index(NO_INDEX) {}
+    };
+
+    static const size_t NO_INDEX = (size_t) -1;
+
+    std::vector<Step> steps;
+    size_t count;
+
+    bool add(const char* pointer, size_t length)
+    {
+      const char* end = pointer + length;
+      if (pointer != end && *pointer != '/')
+        return false;
+
+      std::vector<std::string> tokens;
+      for (const char* p = pointer ; p != end ; )
+      {
+        std::string token;
+        for (p++ ; p != end && *p != '/' ; p++)
+        {
+          if (*p != '~')
+            token += *p;
+          else if (p + 1 != end && (p[1] == '0' || p[1] == '1'))
+            token += *++p == '0' ? '~' : '/';
+          else
+            return false;
+        }
+        tokens.push_back(token);
+      }
+
+      size_t step = 0;
+      for (size_t ii = 0 ; ii < tokens.size() ; ii++)
+      {
+        size_t next = child(step, tokens[ii].data(), tokens[ii].size());
+        if (!next)
+        {
+          next = steps.size();
+          steps.push_back(Step());
+          steps[next].token = tokens[ii];
+          steps[next].index = parseIndex(tokens[ii]);
+          steps[step].children.push_back(next);
+        }
+        step = next;
+      }
+      steps[step].targets.push_back(count++);
+      return true;
+    }
+
+    /* Array indices are decimal without leading zeros. "-", which
+       names the element past the end, never matches. */
+    static size_t parseIndex(const std::string& token)
+    {
+      if (token.empty() || token.size() > 18 || (token[0] == '0' && token.size() > 1))
+        return NO_INDEX;
+      size_t index = 0;
+      for (size_t ii = 0 ; ii < token.size() ; ii++)
+      {
+        if (token[ii] < '0' || token[ii] > '9')
+          return NO_INDEX;
+        index = index * 10 + (token[ii] - '0');
+      }
+      return index;
+    }
+
+    /* The child of step with the given token, or 0 */
+    size_t child(size_t step, const char* token, size_t length) const
+    {
+      const std::vector<size_t>& children = steps[step].children;
+      for (size_t ii = 0 ; ii < children.size() ; ii++)
+      {
+        const std::string& t = steps[children[ii]].token;
+        if (t.size() == length && memcmp(t.data(), token, length) == 0)
+          return children[ii];
+      }
+      return 0;
+    }
+
+    size_t child(size_t step, size_t index) const
+    {
+      const std::vector<size_t>& children = steps[step].children;
+      for (size_t ii = 0 ; ii < children.size() ; ii++)
+      {
+        if (steps[children[ii]].index == index)
+          return children[ii];
+      }
+      return 0;
+    }
+
+    /* Read past the value at p, which step leads to, recording it for
+       the pointers ending there and descending towards the ones that
+       continue. Stops early, with p anywhere, once left drops to 0. */
+    bool visit(char*& p, size_t step, std::vector<Cursor>& out, size_t& left) const
+    {
+      const Step& at = steps[step];
+      impl::chomp(p);
+      for (size_t ii = 0 ; ii < at.targets.size() ; ii++)
+      {
+        if (*p && !out[at.targets[ii]].valid())
+        {
+          out[at.targets[ii]] = Cursor(p);
+          left--;
+        }
+      }
+      if (!left)
+        return true;
+      if (at.children.empty() || (*p != '{' && *p != '['))
+        return impl::skipValue(p);
+
+      char kind = *p++;
+      char closer = kind == '{' ? '}' : ']';
+      for (size_t idx = 0 ; ; idx++)
+      {
+        impl::chomp(p);
+        if (*p == closer)
+        {
+          p++;
+          return true;
+        }
+
+        size_t next;
+        if (kind == '{')
+        {
+          const char* begin;
+          size_t length;
+          bool escaped;
+          if (!impl::scanCharString(p, begin, length, escaped))
+            return false;
+          impl::chomp(p);
+          if (*p != ':')
+            return impl::fail(E_EXPECTED_COLON, p);
+          p++;
+          if (escaped)
+          {
+            std::string key = StringRef(begin, length, true).str();
+            next = child(step, key.data(), key.size());
+          }
+          else
+            next = child(step, begin, length);
+        }
+        else
+          next = child(step, idx);
+
+        if (next ? !visit(p, next, out, left) : !impl::skipValue(p))
+          return false;
+        if (!left)
+          return true;
+
+        impl::chomp(p);
+        if (*p == ',')
+          p++;
+        else if (*p != closer)
+          return impl::fail(E_EXPECTED_SEPARATOR, p);
+      }
+    }
+  };
+
+  /* Binding JSON objects straight to C++ structs. A struct's members are
+     listed once with the JSONPARSER_BIND macro:
+
+       struct Endpoint { std::string host; int port; std::vector<std::string> tags; };
+       JSONPARSER_BIND(Endpoint, JSONPARSER_FIELD(host) JSONPARSER_FIELD(port)
+                                 JSONPARSER_FIELD_NAMED(tags, "tag-list"))
+
+     at namespace scope, outside any namespace. decode() then reads text
+     into an Endpoint, and encode() writes one out in the format of
+     Json::write. Members may be numbers, bool, std::string, std::vector
+     of any of these, or other bound structs; other types are supported
+     by specializing Json::Convert. */
+  template<typename _T>
+  struct Fields;
+
+#define JSONPARSER_BIND(type, fields)                                   \
+  namespace Json {                                                      \
+    template<> struct Fields<type>                                      \
+    {                                                                   \
+      typedef type Bound;                                               \
+      static void list(std::vector<Json::impl::FieldInfo>& out) { fields } \
+    };                                                                  \
+  }
+#define JSONPARSER_FIELD_NAMED(member, key)                             \
+  out.push_back(Json::impl::fieldOf(&Bound::member).make<&Bound::member>(key));
+#define JSONPARSER_FIELD(member) JSONPARSER_FIELD_NAMED(member, #member)
+
+  template<typename _T>
+  struct Convert;
+
+  namespace impl {
+
+    /* A bound member: its key, and how to read and write it through a
+       pointer to its struct */
+    struct FieldInfo
+    {
+      const char* key;
+      bool (*read)(char*& s, void* object, size_t depth);
+      void (*write)(const void* object, std::stringstream& out);
+    };
+
+    template<typename _S, typename _T>
+    struct FieldOf
+    {
+      template<_T _S::*_M>
+      static bool read(char*& s, void* object, size_t depth)
+      {
+        return Convert<_T>::read(s, static_cast<_S*>(object)->*_M, depth);
+      }
+
+      template<_T _S::*_M>
+      static void write(const void* object, std::stringstream& out)
+      {
+        Convert<_T>::write(static_cast<const _S*>(object)->*_M, out);
+      }
+
+      template<_T _S::*_M>
+      static FieldInfo make(const char* key)
+      {
+        FieldInfo field = { key, &read<_M>, &write<_M> };
+        return field;
+      }
+    };
+
+    template<typename _S, typename _T>
+    FieldOf<_S, _T> fieldOf(_T _S::*)
+    {
+      return FieldOf<_S, _T>();
+    }
+
+    /* The fields of a bound struct, with a perfect hash of their keys:
+       a seed is searched for under which every key gets a slot of its
+       own, so a lookup is one hash, one probe and one compare. Should no
+       seed work, keys are compared one by one instead. */
+    class FieldTable
+    {
+    public:
+      explicit FieldTable(const std::vector<FieldInfo>& list) : seed(0), shift(32)
+      {
+        for (size_t ii = 0 ; ii < list.size() ; ii++)
+        {
+          bool seen = false;
+          for (size_t jj = 0 ; jj < fields.size() && !seen ; jj++)
+            seen = strcmp(fields[jj].key, list[ii].key) == 0;
+          if (seen)
+            continue;
+          fields.push_back(list[ii]);
+          lengths.push_back(strlen(list[ii].key));
+          prefixes.push_back(fields.size() == 1 ? "\"" : ", \"");
+          prefixes.back() += escape(list[ii].key) + "\" : ";
+        }
+        if (!fields.empty())
+          build();
+      }
+
+      size_t size() const { return fields.size(); }
+      const FieldInfo& field(size_t idx) const { return fields[idx]; }
+
+      /* The member key is written as by formatObject, with the comma
+         separating it from the previous one */
+      const std::string& prefix(size_t idx) const { return prefixes[idx]; }
+
+      const FieldInfo* find(const char* key, size_t length) const
+      {
+        if (fields.empty())
+          return NULL;
+        if (slots.empty())
+        {
+          for (size_t ii = 0 ; ii < fields.size() ; ii++)
+          {
+            if (lengths[ii] == length && memcmp(fields[ii].key, key, length) == 0)
+              return &fields[ii];
+          }
+          return NULL;
+        }
+        uint32_t idx = slots[slot(key, length)];
+        if (idx == EMPTY || lengths[idx] != length || memcmp(fields[idx].key, key, length) != 0)
+          return NULL;
+        return &fields[idx];
+      }
+
+    private:
+      static const uint32_t EMPTY = 0xffffffffu;
+
+      std::vector<FieldInfo> fields;
+      std::vector<size_t> lengths;
+      std::vector<std::string> prefixes;
+      std::vector<uint32_t> slots;
+      uint32_t seed;
+      int shift;
+
+      /* hashKey, started from a basis that depends on the seed */
+      size_t slot(const char* key, size_t length) const
+      {
+        uint32_t h = 2166136261u ^ (seed * 2654435761u);
+        for (size_t ii = 0 ; ii < length ; ii++)
+          h = (h ^ (unsigned char) key[ii]) * 16777619u;
+        return (h * 2654435761u) >> shift;
+      }
+
+      /* Try seeds with at least two slots per key, then with more, up to
+         sixteen. Failing that, slots is left empty for a linear lookup. */
+      void build()
+      {
+        for (shift = 31 ; shift > 0 ; shift--)
+        {
+          size_t capacity = (size_t) 1 << (32 - shift);
+          if (capacity < fields.size() * 2)
+            continue;
+          if (capacity > fields.size() * 16)
+            break;
+          for (seed = 0 ; seed < 256 ; seed++)
+          {
+            slots.assign(capacity, (uint32_t) EMPTY);
+            size_t ii = 0;
+            for ( ; ii < fields.size() && slots[slot(fields[ii].key, lengths[ii])] == EMPTY ; ii++)
+              slots[slot(fields[ii].key, lengths[ii])] = (uint32_t) ii;
+            if (ii == fields.size())
+              return;
+          }
+        }
+        slots.clear();
+      }
+    };
+
+    template<typename _S>
+    std::vector<FieldInfo> fieldList()
+    {
+      std::vector<FieldInfo> list;
+      Fields<_S>::list(list);
+      return list;
+    }
+
+    /* The FieldTable of a bound struct, built on first use */
+    template<typename _S>
+    const FieldTable& fieldTable()
+    {
+      static const FieldTable table(fieldList<_S>());
+      return table;
+    }
+
+    /* Read an object into the fields of a bound struct. depth is how
+       many more levels of containers may open, this one included. */
+    inline bool readStruct(char*& s, void* object, const FieldTable& table, size_t depth)
+    {
+      chomp(s);
+      if(*s != '{')
+        return fail(E_WRONG_TYPE, s);
+      if(depth == 0)
+        return fail(E_TOO_DEEP, s);
+      s++;
+      chomp(s);
+
+      while(*s != '}')
+      {
+        const char* begin;
+        size_t length;
+        bool escaped;
+        if(!scanCharString(s, begin, length, escaped))
+          return false;
+        chomp(s);
+        if(*s != ':')
+          return fail(E_EXPECTED_COLON, s);
+        s++;
+        chomp(s);
+
+        const FieldInfo* field;
+        if(escaped) {
+          std::string key = StringRef(begin, length, true).str();
+          field = table.find(key.data(), key.size());
+        }
+        else
+          field = table.find(begin, length);
+
+        // a null member leaves its field as it was
+        ParsedNumber num;
+        if(!field || *s == 'n') {
+          if(field ? scanLiteral(s, num) != L_NULL : !skipValue(s))
+            return false;
+        }
+        else if(!field->read(s, object, depth - 1))
+          return false;
+
+        chomp(s);
+        if(*s == ',') {
+          s++;
+          chomp(s);
+        }
+        else if(*s != '}')
+          return fail(E_EXPECTED_SEPARATOR, s);
+      }
+      s++;
+      return true;
+    }
+
+    inline void writeStruct(const void* object, const FieldTable& table, std::stringstream& out)
+    {
+      out << "{";
+      for(size_t ii = 0 ; ii < table.size() ; ii++)
+      {
+        out << table.prefix(ii);
+        table.field(ii).write(object, out);
       }
+      out << "}";
     }
 
+    /* Read a number literal, which Node::as then converts */
+    inline bool readNumber(char*& s, dom::Node& out)
+    {
+      chomp(s);
+      if(!isDigit(*s) && *s != '-')
+        return fail(E_WRONG_TYPE, s);
+      ParsedNumber num;
+      if(scanLiteral(s, num) != L_NUMBER)
+        return false;
+      if (num.kind == N_INT64)
+        out = dom::Node::makeInt64((int64_t) num.bits);
+      else if (num.kind == N_UINT64)
+        out = dom::Node::makeUInt64(num.bits);
+      else
+        out = dom::Node::makeNumber(num.d);
+      return true;
+    }
+
+    /* Integers must hold the number exactly and fit in _T */
+    template<typename _T>
+    struct ConvertInteger
+    {
+      static bool read(char*& s, _T& out, size_t)
+      {
+        dom::Node node;
+        chomp(s);
+        const char* at = s;
+        if (!readNumber(s, node))
+          return false;
+        if (std::numeric_limits<_T>::is_signed)
+        {
+          int64_t v;
+          if (!node.as(v) || v < (int64_t) std::numeric_limits<_T>::min()
+              || v > (int64_t) std::numeric_limits<_T>::max())
+            return fail(E_WRONG_TYPE, at);
+          out = (_T) v;
+        }
+        else
+        {
+          uint64_t v;
+          if (!node.as(v) || v > (uint64_t) std::numeric_limits<_T>::max())
+            return fail(E_WRONG_TYPE, at);
+          out = (_T) v;
+        }
+        return true;
+      }
+
+      static void write(_T in, std::stringstream& out) { out << in; }
+    };
+
+    template<typename _T>
+    struct ConvertFloat
+    {
+      static bool read(char*& s, _T& out, size_t)
+      {
+        dom::Node node;
+        if (!readNumber(s, node))
+          return false;
+        out = (_T) node.number();
+        return true;
+      }
+
+      static void write(_T in, std::stringstream& out) { out << in; }
+    };
 
   }; // namespace
 
+  /* How a member of type _T is read and written. Bound structs are
+     read as objects of their fields. read is given how many more levels
+     of containers may open, and fails with E_TOO_DEEP at the one that
+     would go past it. */
+  template<typename _T>
+  struct Convert
+  {
+    static bool read(char*& s, _T& out, size_t depth)
+    {
+      return impl::readStruct(s, &out, impl::fieldTable<_T>(), depth);
+    }
 
+    static void write(const _T& in, std::stringstream& out)
+    {
+      impl::writeStruct(&in, impl::fieldTable<_T>(), out);
+    }
+  };
 
-  /* Read a JSON Value from a string of characters */
-  inline Value* read(const char* s)
+  template<> struct Convert<short> : impl::ConvertInteger<short> {};
+  template<> struct Convert<unsigned short> : impl::ConvertInteger<unsigned short> {};
+  template<> struct Convert<int> : impl::ConvertInteger<int> {};
+  template<> struct Convert<unsigned int> : impl::ConvertInteger<unsigned int> {};
+  template<> struct Convert<long> : impl::ConvertInteger<long> {};
+  template<> struct Convert<unsigned long> : impl::ConvertInteger<unsigned long> {};
+  template<> struct Convert<long long> : impl::ConvertInteger<long long> {};
+  template<> struct Convert<unsigned long long> : impl::ConvertInteger<unsigned long long> {};
+  template<> struct Convert<float> : impl::ConvertFloat<float> {};
+  template<> struct Convert<double> : impl::ConvertFloat<double> {};
+
+  template<>
+  struct Convert<bool>
   {
-    char* p = (char*) s;
-    return impl::parseGeneric(p);
-  }
+    static bool read(char*& s, bool& out, size_t)
+    {
+      impl::ParsedNumber num;
+      impl::chomp(s);
+      if (*s != 't' && *s != 'f')
+        return impl::fail(E_WRONG_TYPE, s);
+      impl::Literal literal = impl::scanLiteral(s, num);
+      if (literal != impl::L_TRUE && literal != impl::L_FALSE)
+        return false;
+      out = literal == impl::L_TRUE;
+      return true;
+    }
+
+    static void write(bool in, std::stringstream& out) { out << (in ? "true" : "false"); }
+  };
+
+  template<>
+  struct Convert<std::string>
+  {
+    static bool read(char*& s, std::string& out, size_t)
+    {
+      const char* begin;
+      size_t length;
+      bool escaped;
+      impl::chomp(s);
+      if (*s != '"')
+        return impl::fail(E_WRONG_TYPE, s);
+      if (!impl::scanCharString(s, begin, length, escaped))
+        return false;
+      if (!escaped)
+      {
+        out.assign(begin, length);
+        return true;
+      }
+      out.resize(length);
+      if (!impl::unescape(begin, begin + length, &out[0], length))
+        return false;
+      out.resize(length);
+      return true;
+    }
+
+    static void write(const std::string& in, std::stringstream& out) { impl::formatString(in, out); }
+  };
 
-  /* Read a JSON Value from a string of characters. Returns true if 
-     parsing succeeds and top-level Value type matches the type of _T */
   template<typename _T>
-  bool read(const char* s, const _T*& out)
+  struct Convert<std::vector<_T> >
   {
-    Value* parsed = read(s);
-    if (parsed && parsed->getType() == _T::TYPE)
+    static bool read(char*& s, std::vector<_T>& out, size_t depth)
     {
-      out = static_cast<const _T*>(parsed);
+      impl::chomp(s);
+      if (*s != '[')
+        return impl::fail(E_WRONG_TYPE, s);
+      if (depth == 0)
+        return impl::fail(E_TOO_DEEP, s);
+      s++;
+      impl::chomp(s);
+      out.clear();
+
+      while (*s != ']')
+      {
+        if (!readElement(s, out, depth - 1))
+          return false;
+        impl::chomp(s);
+        if (*s == ',')
+        {
+          s++;
+          impl::chomp(s);
+        }
+        else if (*s != ']')
+          return impl::fail(E_EXPECTED_SEPARATOR, s);
+      }
+      s++;
       return true;
     }
-    return false;
+
+    static void write(const std::vector<_T>& in, std::stringstream& out)
+    {
+      out << "[";
+      for (size_t ii = 0 ; ii < in.size() ; ++ii)
+      {
+        if (ii > 0) out << ", ";
+        Convert<_T>::write(in[ii], out);
+      }
+      out << "]";
+    }
+
+  private:
+    template<typename _E>
+    static bool readElement(char*& s, std::vector<_E>& out, size_t depth)
+    {
+      out.push_back(_E());
+      return Convert<_E>::read(s, out.back(), depth);
+    }
+
+    static bool readElement(char*& s, std::vector<bool>& out, size_t depth)
+    {
+      bool v;
+      if (!Convert<bool>::read(s, v, depth))
+        return false;
+      out.push_back(v);
+      return true;
+    }
+  };
+
+  /* Read a value of a bound struct, or of any type with a Convert, from
+     a string of characters. Returns false if the text is malformed or
+     holds a value of another type, see lastError(); members whose keys
+     are not bound are skipped, and fields missing from the text keep
+     their values. Containers may nest at most maxDepth deep. */
+  template<typename _T>
+  bool decode(const char* s, _T& out, size_t maxDepth = DEFAULT_MAX_DEPTH)
+  {
+    impl::begin(s);
+    char* p = (char*) s;
+    return Convert<_T>::read(p, out, maxDepth);
   }
 
-  /* Write a JSON Value to a std::stringstream */
-  inline void write(const Value* value, std::stringstream& ss) {
-    impl::formatGeneric(value, ss);
+  /* Write a value of a bound struct to a std::stringstream */
+  template<typename _T>
+  void encode(const _T& in, std::stringstream& ss)
+  {
+    Convert<_T>::write(in, ss);
   }
 
-  /* Write a JSON Value and return a std::string containing the 
-     formatted data */
-  inline std::string write(const Value* value) {
+  /* Write a value of a bound struct and return a std::string containing
+     the formatted data */
+  template<typename _T>
+  std::string encode(const _T& in)
+  {
     std::stringstream ss;
-    write(value, ss);
+    encode(in, ss);
     return ss.str();
   }
 
@@ -0,0 +1,82 @@
+/* The harness shared by the tests of JsonParser.h. Each file holds the
+   tests of one feature; TEST registers a function that main() runs,
+   and CHECK reports a failed condition and carries on. Written in C++98
+   so that the tests build at each language level the header supports. */
+
+#ifndef JSONPARSER_TESTS_CHECK_H_
+#define JSONPARSER_TESTS_CHECK_H_
+
+#include "JsonParser.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern int failures;
+
+#define CHECK(cond)                                                     \
+  do {                                                                  \
+    if (!(cond)) {                                                      \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                       \
+    }                                                                   \
+  } while (0)
+
+typedef void (*TestFunction)();
+
+struct TestCase
+{
+  const char* name;
+  TestFunction run;
+};
+
+std::vector<TestCase>& testCases();
+
+struct TestRegistrar
+{
+  TestRegistrar(const char* name, TestFunction run)
+  {
+    TestCase test = { name, run };
+    testCases().push_back(test);
+  }
+};
+
+#define TEST(name)                                                      \
+  static void name();                                                   \
+  static TestRegistrar name##Registrar(#name, name);                    \
+  static void name()
+
+/* The Document's tree written back as text, or "error" */
+std::string docText(const char* s, int flags = Json::P_DEFAULT);
+
+/* depth copies of open followed by as many of close */
+std::string nested(const char* open, const char* close, size_t depth);
+
+/* Calls to operator new so far, on any thread. Counted under C++11. */
+size_t allocations();
+
+#if defined(JSONPARSER_CXX11)
+/* While on, operator new throws std::bad_alloc on every thread but the
+   one running main() */
+void failOtherThreads(bool on);
+#endif
+
+/* Records every event as text, so that two parses can be compared */
+struct Events : Json::Handler<Events>
+{
+  std::string log;
+
+  bool null() { log += "n "; return true; }
+  bool boolean(bool in) { log += in ? "t " : "f "; return true; }
+  bool number(double in) { char buf[32]; sprintf(buf, "d%.17g ", in); log += buf; return true; }
+  bool int64(int64_t in) { char buf[32]; sprintf(buf, "i%lld ", (long long) in); log += buf; return true; }
+  bool uint64(uint64_t in) { char buf[32]; sprintf(buf, "u%llu ", (unsigned long long) in); log += buf; return true; }
+  bool string(const char* s, size_t n) { log += "s" + std::string(s, n) + " "; return true; }
+  bool key(const char* s, size_t n) { log += "k" + std::string(s, n) + " "; return true; }
+  bool startObject() { log += "{ "; return true; }
+  bool endObject() { log += "} "; return true; }
+  bool startArray() { log += "[ "; return true; }
+  bool endArray() { log += "] "; return true; }
+};
+
+#endif /* JSONPARSER_TESTS_CHECK_H_ */
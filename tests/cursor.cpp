@@ -0,0 +1,29 @@
+/* Json::Cursor: reading values straight from the text */
+
+#include "check.h"
+
+TEST(testCursor)
+{
+  const char* text = "{\"events\":[{\"latency\":1.5},{\"latency\":2,\"name\":\"b\\\"c\"}],\"n\":null}";
+  double latency = 0;
+  std::string name;
+  CHECK(Json::Cursor(text)["events"][1]["latency"].as(latency) && latency == 2);
+  CHECK(Json::Cursor(text)["events"][1]["name"].as(name) && name == "b\"c");
+  CHECK(Json::Cursor(text)["events"].size() == 2);
+  CHECK(!Json::Cursor(text)["events"][2]["latency"].as(latency));
+  CHECK(!Json::Cursor(text)["missing"].valid());
+  CHECK(Json::Cursor(text)["n"].isNull());
+
+  Json::StringRef key;
+  Json::Cursor member = Json::Cursor(text).first();
+  CHECK(member.key(key) && key.str() == "events");
+  CHECK(member.next().key(key) && key.str() == "n");
+
+  // a trailing comma ends the container like its closing bracket
+  CHECK(Json::Cursor("[1,]").size() == 1);
+  CHECK(Json::Cursor(" [ 1 , ] ")[0].valid() && !Json::Cursor(" [ 1 , ] ")[1].valid());
+  CHECK(!Json::Cursor("[1,]").first().next().valid());
+  CHECK(Json::Cursor("{\"a\":1,}").size() == 1);
+  CHECK(!Json::Cursor("{\"a\":1,}").first().next().valid());
+  CHECK(!Json::Cursor("{\"a\":1,}")["b"].valid());
+}
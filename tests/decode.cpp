@@ -0,0 +1,73 @@
+/* decode and encode: JSON objects bound to C++ structs */
+
+#include "check.h"
+
+struct Tree
+{
+  std::vector<Tree> kids;
+  int id;
+  Tree() : id(0) {}
+};
+JSONPARSER_BIND(Tree, JSONPARSER_FIELD(kids) JSONPARSER_FIELD(id))
+
+struct Endpoint
+{
+  std::string host;
+  int port;
+  std::vector<std::string> tags;
+  bool secure;
+  Endpoint() : port(0), secure(false) {}
+};
+JSONPARSER_BIND(Endpoint,
+                JSONPARSER_FIELD(host)
+                JSONPARSER_FIELD(port)
+                JSONPARSER_FIELD(tags)
+                JSONPARSER_FIELD_NAMED(secure, "tls"))
+
+/* Decoding counts the levels of a self-referential struct */
+TEST(testDecodeDepth)
+{
+  std::string trees = nested("{\"kids\":[", "]}", Json::DEFAULT_MAX_DEPTH / 2);
+  Tree tree;
+  CHECK(Json::decode(trees.c_str(), tree));
+  trees = nested("{\"kids\":[", "]}", 200000);
+  CHECK(!Json::decode(trees.c_str(), tree));
+  CHECK(Json::lastError().code == Json::E_TOO_DEEP);
+}
+
+TEST(testDecode)
+{
+  Endpoint e;
+  CHECK(Json::decode("{\"host\":\"h\",\"port\":443,\"tags\":[\"a\",\"b\"],\"tls\":true,\"other\":[{}]}", e));
+  CHECK(e.host == "h" && e.port == 443 && e.tags.size() == 2 && e.tags[1] == "b" && e.secure);
+  CHECK(Json::encode(e) == "{\"host\" : \"h\", \"port\" : 443, \"tags\" : [\"a\", \"b\"], \"tls\" : true}");
+  CHECK(!Json::decode("{\"port\":70000000000}", e));
+  CHECK(Json::lastError().code == Json::E_WRONG_TYPE);
+
+  // a field is left alone when its value does not convert
+  e.secure = true;
+  CHECK(!Json::decode("{\"tls\":tru}", e) && e.secure);
+  CHECK(!Json::decode("{\"tls\":falsey}", e) && e.secure);
+  CHECK(!Json::decode("{\"tls\":1}", e) && e.secure);
+  CHECK(Json::decode("{\"tls\":false}", e) && !e.secure);
+
+  // a table of keys that no seed hashes perfectly is searched linearly
+  std::vector<std::string> names;
+  for (int ii = 0 ; ii < 2000 ; ii++)
+  {
+    char key[32];
+    sprintf(key, "field%d", ii);
+    names.push_back(key);
+  }
+  std::vector<Json::impl::FieldInfo> list;
+  for (size_t ii = 0 ; ii < names.size() ; ii++)
+  {
+    Json::impl::FieldInfo field = { names[ii].c_str(), NULL, NULL };
+    list.push_back(field);
+  }
+  Json::impl::FieldTable table(list);
+  CHECK(table.size() == 2000);
+  for (size_t ii = 0 ; ii < names.size() ; ii++)
+    CHECK(table.find(names[ii].data(), names[ii].size()) == &table.field(ii));
+  CHECK(table.find("field2000", 9) == NULL);
+}
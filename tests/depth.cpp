@@ -0,0 +1,46 @@
+/* The nesting limit, the same for every entry point */
+
+#include "check.h"
+
+TEST(testDepth)
+{
+  const size_t limit = Json::DEFAULT_MAX_DEPTH;
+  std::string deepest = nested("[", "]", limit);
+  std::string tooDeep = nested("[", "]", limit + 1);
+  std::string hostile = nested("[", "]", 200000);
+  const std::string* inputs[] = { &deepest, &tooDeep, &hostile };
+
+  for (size_t ii = 0 ; ii < 3 ; ii++)
+  {
+    const char* s = inputs[ii]->c_str();
+    bool ok = ii == 0;
+
+    Json::Document doc;
+    CHECK(doc.parse(s) == ok);
+    CHECK(ok || doc.error().code == Json::E_TOO_DEEP);
+    std::string commented = *inputs[ii] + "//";
+    CHECK(doc.parse(commented.c_str()) == ok);
+    CHECK(ok || doc.error().code == Json::E_TOO_DEEP);
+
+    Json::Value* v = Json::read(s);
+    CHECK((v != NULL) == ok);
+    CHECK(ok || Json::lastError().code == Json::E_TOO_DEEP);
+    delete v;
+
+    Events events;
+    CHECK(Json::parse(s, events) == ok);
+    CHECK(ok || Json::lastError().code == Json::E_TOO_DEEP);
+
+    Json::PushParser<Events> push(events);
+    CHECK((push.feed(s, strlen(s)) && push.finish()) == ok);
+    CHECK(ok || push.error().code == Json::E_TOO_DEEP);
+
+    Json::Error err = Json::validate(s);
+    CHECK((err.code == Json::E_NONE) == ok);
+    CHECK(ok || err.code == Json::E_TOO_DEEP);
+  }
+
+  Json::Document shallow;
+  shallow.setMaxDepth(2);
+  CHECK(shallow.parse("[[1]]") && !shallow.parse("[[[1]]]"));
+}
@@ -0,0 +1,39 @@
+/* Json::Document: parsing into an arena and reading through views */
+
+#include "check.h"
+
+TEST(testDocument)
+{
+  const char* text = "{\"name\" : \"a\\tb\", \"list\" : [1, 2.5, true, null], \"o\" : {}}";
+  CHECK(docText(text) == text);
+
+  Json::Document doc;
+  Json::dom::Object root;
+  std::string name;
+  double second = 0;
+  Json::dom::Array list;
+  CHECK(doc.parse(text));
+  CHECK(doc.root(root) && root.size() == 3 && root.get("name", name) && name == "a\tb");
+  CHECK(root.get("list", list) && list.size() == 4 && list.get(1, second) && second == 2.5);
+  CHECK(list[3].isNull());
+  CHECK(!root.get("list", name));
+  CHECK(root.get("missing") == NULL);
+
+  CHECK(!doc.parse("[1, 2"));
+  CHECK(doc.root() == NULL);
+  CHECK(doc.parse("\"top\"") && doc.root(name) && name == "top");
+}
+
+/* Many small values fill several arena blocks */
+TEST(testDocumentArena)
+{
+  std::string text = "[";
+  for (int ii = 0 ; ii < 20000 ; ii++)
+    text += std::string(ii ? "," : "") + "[\"a string long enough to need its own bytes\",{}]";
+  text += "]";
+  Json::Document doc;
+  Json::dom::Array items, item;
+  std::string s;
+  CHECK(doc.parse(text.c_str()) && doc.root(items) && items.size() == 20000);
+  CHECK(items.get(19999, item) && item.get(0, s) && s.size() == 42);
+}
@@ -0,0 +1,53 @@
+/* Parse errors: their codes, offsets, lines and columns */
+
+#include "check.h"
+
+/* A number or literal running into another character is rejected the
+   same way by every entry point */
+TEST(testLiteralEnds)
+{
+  const char* inputs[] = { "01", "1x", "3true", "-01", "1e5x", "[1x]", "[true-]", "{\"a\":1x}" };
+  for (size_t ii = 0 ; ii < sizeof(inputs) / sizeof(inputs[0]) ; ii++)
+  {
+    const char* s = inputs[ii];
+    Json::Document doc;
+    CHECK(!doc.parse(s));
+    CHECK(doc.error().code == Json::E_UNEXPECTED_CHARACTER);
+
+    std::string commented = std::string(s) + " // a comment";
+    Json::Document generic;
+    CHECK(!generic.parse(commented.c_str()));
+    CHECK(generic.error().code == doc.error().code && generic.error().offset == doc.error().offset);
+
+    CHECK(Json::read(s) == NULL);
+    Json::Error readError = Json::lastError();
+    CHECK(readError.code == doc.error().code && readError.offset == doc.error().offset);
+
+    Events events;
+    CHECK(!Json::parse(s, events));
+    Json::Error parseError = Json::lastError();
+    CHECK(parseError.code == doc.error().code && parseError.offset == doc.error().offset);
+
+    Json::PushParser<Events> push(events);
+    CHECK(!(push.feed(s, strlen(s)) && push.finish()));
+    CHECK(push.error().code == Json::E_UNEXPECTED_CHARACTER);
+
+    CHECK(Json::validate(s).code != Json::E_NONE);
+  }
+}
+
+TEST(testErrors)
+{
+  const char* text = "{\n  \"a\": 1x\n}";
+  Json::Document doc;
+  CHECK(!doc.parse(text));
+  const Json::Error& err = doc.error();
+  CHECK(err.code == Json::E_UNEXPECTED_CHARACTER);
+  CHECK(err.offset == 10 && err.line() == 2 && err.column() == 9);
+  CHECK(strlen(err.message()) > 0);
+
+  CHECK(!doc.parse("[1, 2"));
+  CHECK(doc.error().code == Json::E_UNEXPECTED_END);
+  CHECK(!doc.parse("{\"a\" 1}"));
+  CHECK(doc.error().code == Json::E_EXPECTED_COLON);
+}
@@ -0,0 +1,27 @@
+/* Json::parse: a handler called for each value as it is read */
+
+#include "check.h"
+
+/* Stops at the first string */
+struct StopAtString : Events
+{
+  bool string(const char* s, size_t n) { Events::string(s, n); return false; }
+};
+
+TEST(testEvents)
+{
+  const char* text = "{\"a\":[1,-2,18446744073709551615,0.5,\"x\\ny\",true,false,null],\"b\":{}}";
+  Events events;
+  CHECK(Json::parse(text, events));
+  CHECK(events.log == "{ ka [ i1 i-2 u18446744073709551615 d0.5 sx\ny t f n ] kb { } } ");
+
+  Events broken;
+  CHECK(!Json::parse("[1, {\"a\" 2}]", broken));
+  CHECK(broken.log == "[ i1 { ka ");
+
+  // a handler returning false stops the parse where it is
+  StopAtString stop;
+  CHECK(!Json::parse("[1, \"s\", 2]", stop));
+  CHECK(stop.log == "[ i1 ss ");
+  CHECK(Json::lastError().code == Json::E_HANDLER);
+}
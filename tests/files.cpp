@@ -0,0 +1,29 @@
+/* readFile and Document::parseFile */
+
+#include "check.h"
+
+TEST(testFile)
+{
+  const char* path = "jsonparser_test.json";
+  FILE* f = fopen(path, "wb");
+  CHECK(f != NULL);
+  if (!f)
+    return;
+  fputs("{\"values\":[1,2,3]}", f);
+  fclose(f);
+
+  Json::Document doc;
+  Json::dom::Object root;
+  Json::dom::Array values;
+  CHECK(doc.parseFile(path) && doc.root(root) && root.get("values", values) && values.size() == 3);
+  CHECK(doc.parseFile(path, Json::P_INSITU) && doc.root(root) && root.get("values", values));
+
+  Json::Value* v = Json::readFile(path);
+  CHECK(v && v->getType() == Json::T_OBJECT);
+  delete v;
+  remove(path);
+
+  CHECK(!doc.parseFile(path));
+  CHECK(doc.error().code == Json::E_IO);
+  CHECK(Json::readFile(path) == NULL);
+}
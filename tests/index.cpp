@@ -0,0 +1,30 @@
+/* The structural index: a Document built from it must match one built
+   byte by byte, which a comment in the input forces */
+
+#include "check.h"
+
+static void checkIndexed(const std::string& text)
+{
+  std::string plain = docText(text.c_str());
+  CHECK(plain == docText((text + " // generic").c_str()));
+  CHECK(plain != "error");
+}
+
+TEST(testIndex)
+{
+  checkIndexed("{\"a\" : [1, -2.5e3, true, false, null], \"b\" : {\"c\" : \"d\"}}");
+  checkIndexed("[\"[{,:}]\", \"\\\"quoted\\\"\", \"\\\\\", \"\\\\\\\"\"]");
+  checkIndexed("  [ 1 ,2,\t3\n]  ");
+
+  // strings, escapes and literals that straddle the 64-byte blocks
+  for (size_t pad = 0 ; pad < 70 ; pad++)
+  {
+    std::string text = "[\"" + std::string(pad, 'x') + "\\\\\", \"\\\"" + std::string(pad, ']')
+      + "\", 12345678, true, " + std::string(pad, ' ') + "null]";
+    checkIndexed(text);
+  }
+
+  // the same errors either way
+  CHECK(docText("[1, 2") == "error" && docText("[1, 2 //") == "error");
+  CHECK(docText("[\"open]") == "error");
+}
@@ -0,0 +1,24 @@
+/* parseInsitu: strings decoded in the caller's buffer */
+
+#include "check.h"
+
+TEST(testInsitu)
+{
+  char buf[] = "{\"key\\n\" : [\"a\\tb\", \"\\u00e9\", \"plain\"]}";
+  char* end = buf + sizeof(buf) - 1;
+  Json::Document doc;
+  Json::dom::Object root;
+  Json::dom::Array items;
+  Json::StringRef ref;
+  CHECK(doc.parseInsitu(buf, sizeof(buf) - 1) && doc.root(root));
+  CHECK(root.get("key\n", items) && items.size() == 3);
+
+  // decoded and NUL-terminated inside buf, never escaped
+  CHECK(items[0].as(ref) && ref.size() == 3 && !ref.escaped());
+  CHECK(ref.data() >= buf && ref.data() < end && strcmp(ref.data(), "a\tb") == 0);
+  CHECK(items[1].as(ref) && ref.data() >= buf && ref.data() < end && strcmp(ref.data(), "\xc3\xa9") == 0);
+  CHECK(items[2].as(ref) && ref.data() >= buf && ref.data() < end && strcmp(ref.data(), "plain") == 0);
+
+  char bad[] = "[\"\\x\"]";
+  CHECK(!doc.parseInsitu(bad, sizeof(bad) - 1));
+}
@@ -0,0 +1,35 @@
+/* Integer literals kept exact, and Number's conversions between kinds */
+
+#include "check.h"
+
+#include <cmath>
+
+TEST(testIntegers)
+{
+  Json::Document doc;
+  int64_t i = 0;
+  uint64_t u = 0;
+  double d = 0;
+
+  CHECK(doc.parse("9223372036854775807") && doc.root(i) && i == INT64_C(9223372036854775807));
+  CHECK(doc.parse("-9223372036854775808") && doc.root(i) && i == -INT64_C(9223372036854775807) - 1);
+  CHECK(doc.parse("9223372036854775808") && !doc.root(i) && doc.root(u) && u == UINT64_C(9223372036854775808));
+  CHECK(doc.parse("18446744073709551615") && doc.root(u) && u == UINT64_C(18446744073709551615));
+  CHECK(doc.parse("18446744073709551616") && !doc.root(u) && doc.root(d) && d == 18446744073709551616.0);
+  CHECK(doc.parse("-1") && !doc.root(u));
+  CHECK(doc.parse("-0") && doc.root(d) && d == 0 && std::signbit(d));
+
+  Json::Value* v = Json::read("18446744073709551615");
+  Json::Number* n = static_cast<Json::Number*>(v);
+  CHECK(n && n->getKind() == Json::N_UINT64 && n->asUInt64() == UINT64_C(18446744073709551615));
+  CHECK(n && n->asInt64() == INT64_C(9223372036854775807));
+  delete v;
+
+  // doubles out of range are clamped rather than cast
+  CHECK(Json::Number(1e300).asInt64() == INT64_C(9223372036854775807));
+  CHECK(Json::Number(-1e300).asInt64() == -INT64_C(9223372036854775807) - 1);
+  CHECK(Json::Number(1e300).asUInt64() == UINT64_C(18446744073709551615));
+  CHECK(Json::Number(-1.5).asUInt64() == 0);
+  CHECK(Json::Number(-1.5).asInt64() == -1);
+  CHECK(Json::Number(std::sqrt(-1.0)).asInt64() == 0);
+}
@@ -0,0 +1,33 @@
+/* Json::Key: lookups with a hash worked out once */
+
+#include "check.h"
+
+TEST(testKeys)
+{
+  CHECK(Json::Key("id").hash() == Json::impl::hashKey("id", 2));
+  CHECK(Json::Key(std::string("id")).hash() == Json::Key("id", 2).hash());
+#if defined(JSONPARSER_CXX11)
+  static_assert(Json::Key("id").size() == 2, "Key is usable in constant expressions");
+#endif
+
+  // small objects are searched in order, large ones through their index
+  std::string small = "{\"k1\":1,\"k2\":2}";
+  std::string large = "{";
+  for (int ii = 0 ; ii < 40 ; ii++)
+    large += std::string(ii ? "," : "") + "\"k" + Json::encode(ii) + "\":" + Json::encode(ii);
+  large += "}";
+  const std::string* inputs[] = { &small, &large };
+  for (size_t ii = 0 ; ii < 2 ; ii++)
+  {
+    Json::Document doc;
+    Json::dom::Object root;
+    int64_t v = 0;
+    CHECK(doc.parse(inputs[ii]->c_str()) && doc.root(root));
+    CHECK(root.get(Json::Key("k1"), v) && v == 1);
+    CHECK(root.get(Json::Key(std::string("k2")), v) && v == 2);
+    CHECK(root.get(Json::Key("k99")) == NULL);
+#if defined(JSONPARSER_CXX20)
+    CHECK(root.get<"k1">(v) && v == 1);
+#endif
+  }
+}
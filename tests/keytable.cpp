@@ -0,0 +1,18 @@
+/* KeyTable: object keys interned once and shared between Documents */
+
+#include "check.h"
+
+TEST(testKeyTable)
+{
+  Json::KeyTable table;
+  Json::Document a, b;
+  a.setKeyTable(&table);
+  b.setKeyTable(&table);
+  Json::dom::Object x, y;
+  CHECK(a.parse("{\"id\":1}") && a.root(x));
+  CHECK(b.parse("{\"i\\u0064\":2}") && b.root(y));
+  CHECK(x.member(0).key.string().data() == y.member(0).key.string().data());
+  Json::InternedKey id = table.intern("id", 2);
+  int64_t v = 0;
+  CHECK(y.get(id, v) && v == 2);
+}
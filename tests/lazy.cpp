@@ -0,0 +1,35 @@
+/* P_LAZY: containers built on first access, but checked when parsed */
+
+#include "check.h"
+
+TEST(testLazy)
+{
+  const char* text = "{\"a\" : [1, {\"b\" : [2, 3]}], \"c\" : {}, \"d\" : \"e\"}";
+  Json::Document doc;
+  Json::dom::Object root, inner;
+  Json::dom::Array a, b;
+  int64_t v = 0;
+  CHECK(doc.parse(text, Json::P_LAZY) && doc.root(root) && root.size() == 3);
+  CHECK(root.get("a", a) && a.size() == 2 && a.get(1, inner));
+  CHECK(inner.get("b", b) && b.get(1, v) && v == 3);
+  CHECK(Json::write(*doc.root()) == docText(text));
+
+  // the same input accepted and rejected, with the same error, as
+  // when the whole tree is built at once
+  const char* inputs[] = { "[[1 x],2]", "[[1},2]", "[{\"a\" 1}]", "[[\"\\q\"]]", "[[1,],{\"k\":[],},]", "[[tru]]" };
+  for (size_t ii = 0 ; ii < sizeof(inputs) / sizeof(inputs[0]) ; ii++)
+  {
+    Json::Document lazy, eager;
+    bool ok = eager.parse(inputs[ii]);
+    CHECK(lazy.parse(inputs[ii], Json::P_LAZY) == ok);
+    CHECK(lazy.error().code == eager.error().code && lazy.error().offset == eager.error().offset);
+    if (ok)
+      CHECK(Json::write(*lazy.root()) == Json::write(*eager.root()));
+  }
+
+  // the depth limit counts the levels that were stepped over
+  Json::Document shallow;
+  shallow.setMaxDepth(3);
+  CHECK(shallow.parse("[[[1]]]", Json::P_LAZY));
+  CHECK(!shallow.parse("[[[[1]]]]", Json::P_LAZY) && shallow.error().code == Json::E_TOO_DEEP);
+}
@@ -0,0 +1,68 @@
+/* LineBatch and LineIterator: JSON Lines parsed on several threads */
+
+#include "check.h"
+
+#if defined(JSONPARSER_CXX11)
+TEST(testLines)
+{
+  const char* text = "1\n{\"a\":2}\n\nbad\n[3]\n";
+  Json::LineBatch batch(2);
+  CHECK(!batch.parse(text, strlen(text)));
+  CHECK(batch.size() == 4 && batch.errorCount() == 1);
+  CHECK(batch.get(2) == NULL && batch.error().offset == 11);
+  Json::dom::Object second;
+  int64_t a = 0;
+  CHECK(batch.get(1, second) && second.get("a", a) && a == 2);
+
+  std::string many;
+  for (int ii = 0 ; ii < 1000 ; ii++)
+    many += "{\"n\":" + std::to_string(ii) + "}\n";
+  Json::LineIterator lines(many.data(), many.size(), Json::P_DEFAULT, 2, 4096);
+  const Json::dom::Node* record;
+  int64_t expected = 0, n = 0;
+  while (lines.read(record))
+  {
+    Json::dom::Object o;
+    CHECK(record && record->as(o) && o.get("n", n) && n == expected);
+    expected++;
+  }
+  CHECK(expected == 1000);
+}
+
+/* An exception on a worker thread reaches the caller once every thread
+   has stopped */
+TEST(testLinesThrow)
+{
+  std::string many;
+  for (int ii = 0 ; ii < 20000 ; ii++)
+    many += "{\"n\":" + std::to_string(ii) + ",\"s\":\"some padding\"}\n";
+
+  Json::LineBatch batch(4);
+  bool thrown = false;
+  failOtherThreads(true);
+  try {
+    batch.parse(many.data(), many.size());
+  }
+  catch (const std::bad_alloc&) {
+    thrown = true;
+  }
+  failOtherThreads(false);
+  CHECK(thrown);
+  CHECK(batch.parse(many.data(), many.size()) && batch.size() == 20000);
+
+  Json::LineIterator lines(many.data(), many.size(), Json::P_DEFAULT, 2, 1 << 16);
+  const Json::dom::Node* record;
+  size_t count = 0;
+  thrown = false;
+  failOtherThreads(true);
+  try {
+    while (lines.read(record))
+      count++;
+  }
+  catch (const std::bad_alloc&) {
+    thrown = true;
+  }
+  failOtherThreads(false);
+  CHECK(thrown && count < 20000);
+}
+#endif
@@ -0,0 +1,97 @@
+/* Runs every registered test and exits with 1 if any check failed */
+
+#include "check.h"
+
+#include <cstdlib>
+#if defined(JSONPARSER_CXX11)
+#include <atomic>
+#include <thread>
+#endif
+
+int failures = 0;
+
+std::vector<TestCase>& testCases()
+{
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+std::string docText(const char* s, int flags)
+{
+  Json::Document doc;
+  if (!doc.parse(s, flags))
+    return "error";
+  return Json::write(*doc.root());
+}
+
+std::string nested(const char* open, const char* close, size_t depth)
+{
+  std::string s;
+  for (size_t ii = 0 ; ii < depth ; ii++)
+    s += open;
+  for (size_t ii = 0 ; ii < depth ; ii++)
+    s += close;
+  return s;
+}
+
+#if defined(JSONPARSER_CXX11)
+/* Worker threads allocate too, so the count is atomic */
+static std::atomic<size_t> newCalls(0);
+
+static std::atomic<bool> failing(false);
+static const std::thread::id mainThread = std::this_thread::get_id();
+
+size_t allocations()
+{
+  return newCalls.load();
+}
+
+void failOtherThreads(bool on)
+{
+  failing = on;
+}
+
+void* operator new(size_t size)
+{
+  newCalls++;
+  if (failing && std::this_thread::get_id() != mainThread)
+    throw std::bad_alloc();
+  void* p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+#endif
+#else
+size_t allocations()
+{
+  return 0;
+}
+#endif
+
+int main()
+{
+  std::vector<TestCase>& cases = testCases();
+  for (size_t ii = 0 ; ii < cases.size() ; ii++)
+  {
+    int before = failures;
+    cases[ii].run();
+    if (failures != before)
+      fprintf(stderr, "%s: %d checks failed\n", cases[ii].name, failures - before);
+  }
+
+  if (failures)
+    fprintf(stderr, "%d checks failed\n", failures);
+  return failures ? 1 : 0;
+}
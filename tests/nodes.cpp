@@ -0,0 +1,25 @@
+/* Json::dom::Node: the 16-byte values a Document is built of */
+
+#include "check.h"
+
+TEST(testNodes)
+{
+  CHECK(sizeof(Json::dom::Node) == 16);
+
+  Json::Document doc;
+  Json::dom::Array items;
+  CHECK(doc.parse("[1.5, \"ab\", true, null, [0], {\"k\" : 0}]") && doc.root(items) && items.size() == 6);
+  CHECK(items[0].getType() == Json::T_NUMBER && items[0].number() == 1.5);
+  CHECK(items[1].getType() == Json::T_STRING && items[1].string().size() == 2);
+  CHECK(items[2].getType() == Json::T_BOOLEAN && items[2].boolean());
+  CHECK(items[3].isNull());
+  CHECK(items[4].getType() == Json::T_ARRAY);
+  CHECK(items[5].getType() == Json::T_OBJECT);
+}
+
+/* Lengths are 32 bits wide; anything longer is an error, not truncated */
+TEST(testNodeLimits)
+{
+  CHECK(Json::dom::Node::MAX_LENGTH == 0xffffffffu);
+  CHECK(std::string(Json::Error(Json::E_TOO_LARGE, 0).message()) == "string or container too large");
+}
@@ -0,0 +1,48 @@
+/* Number tokens converted to the nearest double, whatever the locale */
+
+#include "check.h"
+
+#include <clocale>
+
+static double toDouble(const std::string& text)
+{
+  Json::Document doc;
+  double d = -1;
+  if (!doc.parse(text.c_str()) || !doc.root(d))
+    return -1;
+  return d;
+}
+
+TEST(testDoubles)
+{
+  CHECK(toDouble("0.1") == 0.1);
+  CHECK(toDouble("-2.5e-3") == -2.5e-3);
+  CHECK(toDouble("4.9e-324") == 4.9406564584124654e-324);
+  CHECK(toDouble("1.7976931348623157e308") == 1.7976931348623157e308);
+  CHECK(toDouble("1e400") > 1.7976931348623157e308);
+  CHECK(toDouble("-1e400") < -1.7976931348623157e308);
+  CHECK(toDouble("1e-400") == 0);
+
+  // values that cannot be computed from their first 19 digits
+  CHECK(toDouble("123456789012345678901234567890") == 1.2345678901234568e+29);
+  CHECK(toDouble("0." + std::string(100, '0') + "12345678901234567890123456789e100") == 0.12345678901234568);
+
+  // halfway between two doubles until the very last digit
+  std::string zeros(200, '0');
+  CHECK(toDouble("9007199254740993") == 9007199254740992.0);
+  CHECK(toDouble("9007199254740993." + zeros + "1") == 9007199254740994.0);
+  CHECK(toDouble("9007199254740993" + zeros + "1e-201") == 9007199254740994.0);
+  CHECK(toDouble("-9007199254740993." + zeros + "1") == -9007199254740994.0);
+}
+
+/* The decimal point is '.' even where the locale says otherwise */
+TEST(testDoublesLocale)
+{
+  const char* previous = setlocale(LC_NUMERIC, NULL);
+  std::string saved = previous ? previous : "C";
+  if (!setlocale(LC_NUMERIC, "de_DE.UTF-8") && !setlocale(LC_NUMERIC, "fr_FR.UTF-8"))
+    return;
+  CHECK(toDouble("1.5") == 1.5);
+  CHECK(toDouble("0." + std::string(150, '0') + "25e151") == 2.5);
+  setlocale(LC_NUMERIC, saved.c_str());
+}
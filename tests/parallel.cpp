@@ -0,0 +1,48 @@
+/* P_PARALLEL: a large top-level array parsed on several threads */
+
+#include "check.h"
+
+#if defined(JSONPARSER_CXX11)
+TEST(testParallel)
+{
+  std::string big = "[";
+  for (int ii = 0 ; ii < 60000 ; ii++)
+  {
+    char item[64];
+    sprintf(item, "%s{\"a\":[%d,2.5,\"x\"],\"b\":true}", ii ? "," : "", ii);
+    big += item;
+  }
+  CHECK(big.size() > Json::impl::PARALLEL_MIN);
+
+  const char* ends[] = { "]", ",]", " , ]", ",,]", "", ",{]" };
+  for (size_t ii = 0 ; ii < sizeof(ends) / sizeof(ends[0]) ; ii++)
+  {
+    std::string s = big + ends[ii];
+    Json::Document serial, parallel;
+    parallel.setThreads(4);
+    bool a = serial.parse(s.c_str());
+    bool b = parallel.parse(s.c_str(), Json::P_PARALLEL);
+    CHECK(a == b);
+    CHECK(serial.error().code == parallel.error().code);
+    if (a && b)
+      CHECK(Json::write(*serial.root()) == Json::write(*parallel.root()));
+  }
+
+  // an exception on a worker thread reaches the caller once every
+  // thread has stopped
+  std::string closed = big + "]";
+  Json::Document doc;
+  doc.setThreads(4);
+  bool thrown = false;
+  failOtherThreads(true);
+  try {
+    doc.parse(closed.c_str(), Json::P_PARALLEL);
+  }
+  catch (const std::bad_alloc&) {
+    thrown = true;
+  }
+  failOtherThreads(false);
+  CHECK(thrown);
+  CHECK(doc.parse(closed.c_str(), Json::P_PARALLEL));
+}
+#endif
@@ -0,0 +1,23 @@
+/* PointerSet: JSON Pointer values extracted in one pass */
+
+#include "check.h"
+
+TEST(testPointers)
+{
+  Json::PointerSet pointers;
+  CHECK(pointers.add("/a/1/b"));
+  CHECK(pointers.add("/c~1d"));
+  CHECK(pointers.add(""));
+  CHECK(pointers.add("/missing"));
+  CHECK(!pointers.add("no-slash"));
+
+  std::vector<Json::Cursor> out;
+  CHECK(pointers.extract("{\"a\":[0,{\"b\":\"x\"}],\"c/d\":4}", out));
+  std::string b;
+  int64_t cd = 0;
+  CHECK(out.size() == 4);
+  CHECK(out[0].as(b) && b == "x");
+  CHECK(out[1].as(cd) && cd == 4);
+  CHECK(out[2].getType() == Json::T_OBJECT);
+  CHECK(!out[3].valid());
+}
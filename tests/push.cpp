@@ -0,0 +1,45 @@
+/* PushParser: the events of Json::parse for input arriving in chunks */
+
+#include "check.h"
+
+TEST(testPush)
+{
+  const char* text = "{\"a\":[1,-2,18446744073709551615,0.5,\"x\\ny\",true,false,null],\"b\":{}}";
+  Events whole;
+  CHECK(Json::parse(text, whole));
+
+  // the same events as Json::parse however the input is cut
+  Events bytes;
+  Json::PushParser<Events> push(bytes);
+  for (const char* p = text ; *p ; p++)
+    CHECK(push.feed(p, 1));
+  CHECK(push.finish());
+  CHECK(bytes.log == whole.log);
+
+  Events several;
+  Json::PushParser<Events> lines(several);
+  CHECK(lines.feed("1 [2]\n{\"c\"", 10) && lines.feed(":3}", 3) && lines.finish());
+  CHECK(several.log == "i1 [ i2 ] { kc i3 } ");
+
+  Events unfinished;
+  Json::PushParser<Events> cut(unfinished);
+  CHECK(cut.feed("[1,", 3) && !cut.finish());
+  CHECK(cut.error().code == Json::E_UNEXPECTED_END);
+
+  // a trailing comma is accepted as by Json::parse, in any chunks
+  const char* trailing[] = { "[1,]", "{\"a\":1,}", "[[1,],{\"b\":[],},]" };
+  for (size_t ii = 0 ; ii < sizeof(trailing) / sizeof(trailing[0]) ; ii++)
+  {
+    Events expected, chunked;
+    CHECK(Json::parse(trailing[ii], expected));
+    Json::PushParser<Events> bytewise(chunked);
+    for (const char* p = trailing[ii] ; *p ; p++)
+      CHECK(bytewise.feed(p, 1));
+    CHECK(bytewise.finish() && chunked.log == expected.log);
+  }
+
+  Events twoCommas;
+  Json::PushParser<Events> doubled(twoCommas);
+  CHECK(!doubled.feed("[1,,]", 5));
+  CHECK(doubled.error().code == Json::E_UNEXPECTED_CHARACTER && doubled.error().offset == 3);
+}
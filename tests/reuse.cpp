@@ -0,0 +1,26 @@
+/* Documents reused from one parse to the next */
+
+#include "check.h"
+
+#if defined(JSONPARSER_CXX11)
+/* A Document reused for similar inputs stops allocating */
+TEST(testReuse)
+{
+  std::string text = "[";
+  for (int ii = 0 ; ii < 50 ; ii++)
+    text += std::string(ii ? "," : "") + "{\"z\":1,\"b\":\"s\\n\",\"a\":[1.5,2],\"b\":3}";
+  text += "]";
+
+  const int modes[] = { Json::P_DEFAULT, Json::P_ZERO_COPY, Json::P_SORTED_KEYS,
+                        Json::P_SORTED_KEYS | Json::P_ZERO_COPY, Json::P_LAZY };
+  for (size_t ii = 0 ; ii < sizeof(modes) / sizeof(modes[0]) ; ii++)
+  {
+    Json::Document doc;
+    CHECK(doc.parse(text.c_str(), modes[ii]));
+    size_t before = allocations();
+    for (int jj = 0 ; jj < 20 ; jj++)
+      CHECK(doc.parse(text.c_str(), modes[ii]));
+    CHECK(allocations() == before);
+  }
+}
+#endif
@@ -0,0 +1,31 @@
+/* P_SORTED_KEYS, and the hash index of large objects */
+
+#include "check.h"
+
+TEST(testSortedKeys)
+{
+  CHECK(docText("{\"b\":1,\"a\":2,\"b\":3}", Json::P_SORTED_KEYS) == "{\"a\" : 2, \"b\" : 3}");
+  // escaped keys are decoded before they are sorted, even without copies
+  const char* escaped = "{\"k5\":1,\"k\\u0035\":2,\"a\":3}";
+  CHECK(docText(escaped, Json::P_SORTED_KEYS) == "{\"a\" : 3, \"k5\" : 2}");
+  CHECK(docText(escaped, Json::P_SORTED_KEYS | Json::P_ZERO_COPY) == "{\"a\" : 3, \"k5\" : 2}");
+
+  // large objects get a hash index
+  std::string large = "{";
+  for (int ii = 40 ; ii-- > 0 ; )
+  {
+    char member[32];
+    sprintf(member, "%s\"k%d\":%d", ii == 39 ? "" : ",", ii, ii);
+    large += member;
+  }
+  large += ",\"k7\":-7}";
+  Json::Document doc;
+  Json::dom::Object root;
+  int64_t v = 0;
+  CHECK(doc.parse(large.c_str(), Json::P_SORTED_KEYS) && doc.root(root) && root.size() == 40);
+  CHECK(root.get("k7", v) && v == -7);
+  CHECK(root.get("k39", v) && v == 39);
+  CHECK(root.member(0).key.string().str() == "k0");
+  CHECK(doc.parse(large.c_str()) && doc.root(root) && root.get("k7", v) && v == -7);
+  CHECK(root.get(std::string("k40")) == NULL);
+}
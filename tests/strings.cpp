@@ -0,0 +1,42 @@
+/* Strings: bulk scanning and escape decoding */
+
+#include "check.h"
+
+static std::string firstString(const char* text, int flags = Json::P_DEFAULT)
+{
+  Json::Document doc;
+  Json::dom::Array items;
+  std::string s;
+  if (!doc.parse(text, flags) || !doc.root(items) || !items.get(0, s))
+    return "error";
+  return s;
+}
+
+TEST(testEscapes)
+{
+  CHECK(firstString("[\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\"]") == "a\"b\\c/d\b\f\n\r\t");
+  CHECK(firstString("[\"\\u0041\\u00e9\\u20ac\"]") == "A\xc3\xa9\xe2\x82\xac");
+  // a surrogate pair is one code point; a lone half becomes U+FFFD
+  CHECK(firstString("[\"\\ud83d\\ude00\"]") == "\xf0\x9f\x98\x80");
+  CHECK(firstString("[\"\\ud83d\"]") == "\xef\xbf\xbd");
+  CHECK(firstString("[\"\\ude00x\"]") == "\xef\xbf\xbdx");
+
+  CHECK(firstString("[\"\\x\"]") == "error");
+  CHECK(firstString("[\"\\u12g4\"]") == "error");
+  CHECK(firstString("[\"\\u12\"]") == "error");
+  CHECK(firstString("[\"open]") == "error");
+}
+
+/* Strings longer than a 16-byte block, with the quote and escapes at
+   every alignment */
+TEST(testLongStrings)
+{
+  for (size_t length = 0 ; length < 70 ; length++)
+  {
+    std::string body(length, 'x');
+    CHECK(firstString(("[\"" + body + "\"]").c_str()) == body);
+    CHECK(firstString(("[\"" + body + "\\n" + body + "\"]").c_str()) == body + "\n" + body);
+  }
+  std::string big(100000, 'y');
+  CHECK(firstString(("[\"" + big + "\"]").c_str()) == big);
+}
@@ -0,0 +1,24 @@
+/* Json::validate: strict RFC 8259 checking without building a tree */
+
+#include "check.h"
+
+TEST(testValidate)
+{
+  CHECK(Json::validate("{\"a\":[1,2.5e3,\"\\u00e9\xc3\xa9\",true,null]}").code == Json::E_NONE);
+  // only length bytes are read: what follows them does not matter
+  CHECK(Json::validate("[1,2]xyz", 5).code == Json::E_NONE);
+  Json::Error cut = Json::validate("[1,2]", 4);
+  CHECK(cut.code != Json::E_NONE && cut.offset <= 4);
+  CHECK(Json::validate(std::string("[1,\0 2]", 7).data(), 7).code != Json::E_NONE);
+
+  // a buffer with no NUL after it
+  std::vector<char> exact(5);
+  memcpy(&exact[0], "[1,2]", 5);
+  CHECK(Json::validate(&exact[0], exact.size()).code == Json::E_NONE);
+  exact[4] = ',';
+  CHECK(Json::validate(&exact[0], exact.size()).code != Json::E_NONE);
+
+  CHECK(Json::validate("[1,\f2]").code != Json::E_NONE);
+  CHECK(Json::validate("\"\xc3\"").code == Json::E_INVALID_UTF8);
+  CHECK(Json::validate("[1] 2").code != Json::E_NONE);
+}
@@ -0,0 +1,29 @@
+/* Whitespace and // comments between tokens */
+
+#include "check.h"
+
+TEST(testWhitespace)
+{
+  CHECK(docText(" \t\r\n\v\f[ 1 ,\n\t2 ] ") == "[1, 2]");
+
+  // runs longer than a 16-byte block, starting at every alignment
+  for (size_t pad = 0 ; pad < 40 ; pad++)
+  {
+    std::string space(pad, ' ');
+    std::string text = space + "[" + space + "1" + std::string(pad, '\n') + "," + space + "2" + space + "]";
+    CHECK(docText(text.c_str()) == "[1, 2]");
+  }
+}
+
+TEST(testComments)
+{
+  CHECK(docText("// leading\n[1, // after a comma\n 2 // before the end\n] // trailing") == "[1, 2]");
+  CHECK(docText("{\"a\" // between key and colon\n : 1}") == "{\"a\" : 1}");
+
+  std::string longComment = "[1, //" + std::string(100, 'c') + "\n2]";
+  CHECK(docText(longComment.c_str()) == "[1, 2]");
+
+  // a single slash is not a comment, and a comment is not a value
+  CHECK(docText("[1 / 2]") == "error");
+  CHECK(docText("// nothing else") == "error");
+}
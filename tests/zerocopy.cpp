@@ -0,0 +1,30 @@
+/* P_ZERO_COPY: strings and keys that refer to the input */
+
+#include "check.h"
+
+TEST(testZeroCopy)
+{
+  const char* text = "{\"plain\" : \"abc\", \"esc\\u0041\" : \"a\\nb\"}";
+  Json::Document doc;
+  Json::dom::Object root;
+  CHECK(doc.parse(text, Json::P_ZERO_COPY) && doc.root(root) && root.size() == 2);
+
+  // unescaped strings point into the input
+  Json::StringRef ref;
+  CHECK(root.get("plain") && root.get("plain")->as(ref));
+  CHECK(ref.data() == strstr(text, "abc") && ref.size() == 3 && !ref.escaped());
+
+  // escaped ones are the raw text, decoded on request
+  CHECK(root.get("escA") && root.get("escA")->as(ref));
+  CHECK(ref.escaped() && ref.data() == strstr(text, "a\\nb") && ref.size() == 4);
+  CHECK(ref.str() == "a\nb");
+  std::string s;
+  CHECK(root.get("escA", s) && s == "a\nb");
+
+  // the escapes are still checked
+  CHECK(!doc.parse("[\"\\q\"]", Json::P_ZERO_COPY));
+
+  // without the flag every string is a copy
+  CHECK(doc.parse(text) && doc.root(root) && root.get("plain")->as(ref));
+  CHECK(ref.data() != strstr(text, "abc") && ref.str() == "abc");
+}